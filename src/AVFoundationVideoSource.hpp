@@ -20,8 +20,10 @@ public:
     void close();
     bool isOpened() const;
 
-    // Copies the latest frame into the provided vector (YUYV format expected)
-    bool getFrame(std::vector<uint8_t>& frameData);
+    // Copies the latest frame into the provided vector (YUYV format expected). timestampUs is
+    // its arrival on the steady clock; sequence counts delivered frames, so gaps are frames
+    // replaced before they were read
+    bool getFrame(std::vector<uint8_t>& frameData, int64_t* timestampUs = nullptr, uint32_t* sequence = nullptr);
 
 private:
     void* impl; // Opaque pointer to the Objective-C implementation class
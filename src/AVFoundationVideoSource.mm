@@ -2,6 +2,7 @@
 #import <CoreVideo/CoreVideo.h>
 #include "AVFoundationVideoSource.hpp"
 #include "P2Pro.hpp" // For dprintf
+#include <chrono>
 #include <mutex>
 #include <vector>
 #include <iostream>
@@ -10,6 +11,8 @@
     std::vector<uint8_t> latestFrame;
     std::mutex frameMutex;
     BOOL hasNewFrame;
+    int64_t latestTimestampUs;
+    uint32_t frameSequence;
 }
 @property (nonatomic, strong) AVCaptureSession *session;
 @property (nonatomic, strong) AVCaptureDeviceInput *input;
@@ -17,7 +20,7 @@
 @property (nonatomic, assign) BOOL isOpened;
 
 - (void)captureOutput:(AVCaptureOutput *)output didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer fromConnection:(AVCaptureConnection *)connection;
-- (bool)getLatestFrame:(std::vector<uint8_t>&)frameData;
+- (bool)getLatestFrame:(std::vector<uint8_t>&)frameData timestamp:(int64_t*)timestampUs sequence:(uint32_t*)sequence;
 @end
 
 @implementation P2ProCaptureDelegate
@@ -26,6 +29,8 @@
     self = [super init];
     if (self) {
         hasNewFrame = NO;
+        latestTimestampUs = 0;
+        frameSequence = 0;
         _isOpened = NO;
     }
     return self;
@@ -57,14 +62,18 @@
     }
     
     hasNewFrame = YES;
+    latestTimestampUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    frameSequence++;
     
     CVPixelBufferUnlockBaseAddress(imageBuffer, kCVPixelBufferLock_ReadOnly);
 }
 
-- (bool)getLatestFrame:(std::vector<uint8_t>&)frameData {
+- (bool)getLatestFrame:(std::vector<uint8_t>&)frameData timestamp:(int64_t*)timestampUs sequence:(uint32_t*)sequence {
     std::lock_guard<std::mutex> lock(frameMutex);
     if (!hasNewFrame) return false;
     frameData = latestFrame;
+    if (timestampUs) *timestampUs = latestTimestampUs;
+    if (sequence) *sequence = frameSequence;
     hasNewFrame = NO; 
     return true;
 }
@@ -205,7 +214,7 @@ bool AVFoundationVideoSource::isOpened() const {
     return delegate.isOpened;
 }
 
-bool AVFoundationVideoSource::getFrame(std::vector<uint8_t>& frameData) {
+bool AVFoundationVideoSource::getFrame(std::vector<uint8_t>& frameData, int64_t* timestampUs, uint32_t* sequence) {
     P2ProCaptureDelegate* delegate = (__bridge P2ProCaptureDelegate*)impl;
-    return [delegate getLatestFrame:frameData];
+    return [delegate getLatestFrame:frameData timestamp:timestampUs sequence:sequence];
 }
@@ -0,0 +1,344 @@
+#include "AlarmEngine.hpp"
+#include "FrameStats.hpp"
+#include "P2Pro.hpp"
+#include "RoiAnalyzer.hpp"
+#include "ThermalCalibration.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AE_NEON 1
+#define AE_SSE2 0
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AE_NEON 0
+#define AE_SSE2 1
+#else
+#define AE_NEON 0
+#define AE_SSE2 0
+#endif
+
+// Y16 is 1/64 K
+static const double CountsPerKelvin = 64.0;
+
+void AlarmEventLog::push(AlarmEvent event) {
+    // Single writer: only this thread advances head
+    uint64_t seq = head.load(std::memory_order_relaxed);
+    Slot &slot = slots[seq % Capacity];
+    event.sequence = seq;
+    slot.version.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.event, &event, sizeof(AlarmEvent));
+    slot.version.store(2 * seq + 2, std::memory_order_release);
+    head.store(seq + 1, std::memory_order_release);
+}
+
+uint64_t AlarmEventLog::read(uint64_t from, AlarmEvent *out, int max, int &count) const {
+    count = 0;
+    uint64_t end = head.load(std::memory_order_acquire);
+    if (end > Capacity && from < end - Capacity) from = end - Capacity;
+    for (; from < end && count < max; ++from) {
+        const Slot &slot = slots[from % Capacity];
+        uint64_t before = slot.version.load(std::memory_order_acquire);
+        if (before != 2 * from + 2) continue; // overwritten by a newer event
+        AlarmEvent copy;
+        std::memcpy(&copy, &slot.event, sizeof(AlarmEvent));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != before) continue;
+        out[count++] = copy;
+    }
+    return from;
+}
+
+AlarmEngine::AlarmEngine(int width, int height)
+        : width(width), height(height), binnedWidth(width / 2), binnedHeight(height / 2),
+          binned((size_t) (width / 2) * (height / 2)) {
+    setParams(params);
+}
+
+void AlarmEngine::setParams(const Params &p) {
+    params = p;
+    params.historySlots = std::max(params.historySlots, 2);
+    resetHistory();
+}
+
+void AlarmEngine::setRules(const std::vector<Rule> &rules) {
+    ruleList = rules;
+    ruleStates.assign(ruleList.size(), RuleState());
+    currentValues.assign(ruleList.size(), 0.0);
+    currentPresent.assign(ruleList.size(), 0);
+    needsPixels = false;
+    for (const Rule &r: ruleList) {
+        needsPixels |= r.source == Source::Pixels && (r.condition == Condition::Rise || r.condition == Condition::Fall);
+    }
+    resetHistory();
+}
+
+void AlarmEngine::resetHistory() {
+    // Planes are only kept when a per-pixel rate rule needs them
+    history.assign(needsPixels ? (size_t) params.historySlots * binned.size() : 0, 0);
+    historyValues.assign((size_t) params.historySlots * ruleList.size(), 0.0);
+    historyPresent.assign((size_t) params.historySlots * ruleList.size(), 0);
+    historyTimes.assign(params.historySlots, 0);
+    historyHead = 0;
+    historyCount = 0;
+    for (RuleState &s: ruleStates) s.pending = 0;
+}
+
+static bool parseSource(const std::string &text, AlarmEngine::Source &source, int &roiId) {
+    roiId = 0;
+    if (text == "frame.max") source = AlarmEngine::Source::FrameMax;
+    else if (text == "frame.min") source = AlarmEngine::Source::FrameMin;
+    else if (text == "frame.mean") source = AlarmEngine::Source::FrameMean;
+    else if (text == "pixels") source = AlarmEngine::Source::Pixels;
+    else if (text.compare(0, 4, "roi:") == 0) {
+        size_t dot = text.find('.');
+        if (dot == std::string::npos) return false;
+        roiId = std::atoi(text.substr(4, dot - 4).c_str());
+        std::string stat = text.substr(dot + 1);
+        if (stat == "max") source = AlarmEngine::Source::RoiMax;
+        else if (stat == "min") source = AlarmEngine::Source::RoiMin;
+        else if (stat == "mean") source = AlarmEngine::Source::RoiMean;
+        else return false;
+        return roiId > 0;
+    } else return false;
+    return true;
+}
+
+bool AlarmEngine::loadRules(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::vector<Rule> rules;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        std::string name, source, condition;
+        Rule rule;
+        if (!(fields >> name) || name[0] == '#') continue;
+        bool ok = (bool) (fields >> source >> condition >> rule.threshold) &&
+                  parseSource(source, rule.source, rule.roiId);
+        if (condition == "above") rule.condition = Condition::Above;
+        else if (condition == "below") rule.condition = Condition::Below;
+        else if (condition == "rise") rule.condition = Condition::Rise;
+        else if (condition == "fall") rule.condition = Condition::Fall;
+        else if (condition == "delta") rule.condition = Condition::Delta;
+        else ok = false;
+
+        std::string option;
+        while (ok && fields >> option) {
+            size_t eq = option.find('=');
+            std::string key = option.substr(0, eq);
+            std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+            if (key == "window") rule.window = std::atof(value.c_str());
+            else if (key == "hysteresis") rule.hysteresis = std::atof(value.c_str());
+            else if (key == "debounce") rule.debounce = std::atoi(value.c_str());
+            else if (key == "reference") ok = parseSource(value, rule.reference, rule.referenceRoiId);
+            else ok = false;
+        }
+        if (!ok) {
+            dprintf("%s:%d: invalid alarm rule\n", path.c_str(), lineNumber);
+            continue;
+        }
+        rule.name = name;
+        rules.push_back(rule);
+    }
+    setRules(rules);
+    return true;
+}
+
+bool AlarmEngine::sourceValue(Source source, int roiId, const FrameStats &stats, const RoiAnalyzer *rois,
+                              double &raw) const {
+    switch (source) {
+        case Source::FrameMax:
+        case Source::Pixels:
+            raw = std::max((double) stats.max, (double) stats.peakValue);
+            return !stats.empty();
+        case Source::FrameMin:
+            raw = stats.min;
+            return !stats.empty();
+        case Source::FrameMean:
+            raw = stats.mean();
+            return !stats.empty();
+        default:
+            break;
+    }
+    if (!rois) return false;
+    const std::vector<Roi> &regions = rois->rois();
+    for (size_t i = 0; i < regions.size(); ++i) {
+        if (regions[i].id != roiId || i >= rois->results().size()) continue;
+        const RoiStats &s = rois->results()[i];
+        if (s.count == 0) return false;
+        raw = source == Source::RoiMax ? s.max : source == Source::RoiMin ? s.min : s.mean;
+        return true;
+    }
+    return false;
+}
+
+int AlarmEngine::historySlotFor(int64_t steadyUs, double window) const {
+    // Newest sample at least one window old; with a window longer than the whole ring the
+    // oldest sample once the ring is full
+    const int64_t windowUs = (int64_t) std::llround(window * 1e6);
+    for (int age = 0; age < historyCount; ++age) {
+        int slot = (historyHead - 1 - age + params.historySlots) % params.historySlots;
+        if (steadyUs - historyTimes[slot] >= windowUs) return slot;
+    }
+    if (historyCount == params.historySlots) return historyHead;
+    return -1;
+}
+
+uint16_t AlarmEngine::maxRise(const uint16_t *older, bool fall) const {
+    const uint16_t *a = fall ? older : binned.data();
+    const uint16_t *b = fall ? binned.data() : older;
+    const int count = (int) binned.size();
+    int i = 0;
+    uint16_t result = 0;
+
+#if AE_SSE2
+    // Saturating a - b is 0 for falls; unsigned max as (x - m) + m
+    __m128i best = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i d = _mm_subs_epu16(_mm_loadu_si128((const __m128i *) (a + i)),
+                                   _mm_loadu_si128((const __m128i *) (b + i)));
+        best = _mm_add_epi16(_mm_subs_epu16(d, best), best);
+    }
+    uint16_t lanes[8];
+    _mm_storeu_si128((__m128i *) lanes, best);
+    for (uint16_t v: lanes) result = std::max(result, v);
+#elif AE_NEON
+    uint16x8_t best = vdupq_n_u16(0);
+    for (; i + 8 <= count; i += 8) {
+        best = vmaxq_u16(best, vqsubq_u16(vld1q_u16(a + i), vld1q_u16(b + i)));
+    }
+    uint16_t lanes[8];
+    vst1q_u16(lanes, best);
+    for (uint16_t v: lanes) result = std::max(result, v);
+#endif
+
+    for (; i < count; ++i) {
+        if (a[i] > b[i]) result = std::max(result, (uint16_t) (a[i] - b[i]));
+    }
+    return result;
+}
+
+static double toKelvin(const ThermalCalibration &calibration, double raw) {
+    double t = calibration.toTemperatureInterpolated((float) raw);
+    switch (calibration.getUnit()) {
+        case TemperatureUnit::Fahrenheit:
+            return (t - 32.0) * 5.0 / 9.0 + 273.15;
+        case TemperatureUnit::Kelvin:
+            return t;
+        default:
+            return t + 273.15;
+    }
+}
+
+void AlarmEngine::evaluate(const uint16_t *y16, const FrameStats &stats, const RoiAnalyzer *rois,
+                           const ThermalCalibration &calibration, int64_t steadyUs, int64_t wallTimeMs) {
+    if (ruleList.empty()) return;
+
+    if (needsPixels) {
+        // 2x2 cell means: a quarter of the work per rate rule and half the noise per cell
+        for (int y = 0; y < binnedHeight; ++y) {
+            const uint16_t *r0 = y16 + (size_t) (2 * y) * width;
+            const uint16_t *r1 = r0 + width;
+            uint16_t *out = binned.data() + (size_t) y * binnedWidth;
+            for (int x = 0; x < binnedWidth; ++x) {
+                out[x] = (uint16_t) (((uint32_t) r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+            }
+        }
+    }
+
+    for (size_t r = 0; r < ruleList.size(); ++r) {
+        currentPresent[r] = sourceValue(ruleList[r].source, ruleList[r].roiId, stats, rois, currentValues[r]);
+    }
+
+    for (size_t r = 0; r < ruleList.size(); ++r) {
+        const Rule &rule = ruleList[r];
+        RuleState &state = ruleStates[r];
+        double excess = 0.0;
+        state.valid = currentPresent[r] != 0;
+
+        if (state.valid) {
+            switch (rule.condition) {
+                case Condition::Above:
+                case Condition::Below: {
+                    double raw = currentValues[r];
+                    if (rule.source == Source::Pixels && rule.condition == Condition::Below) raw = stats.min;
+                    state.value = toKelvin(calibration, raw) - 273.15;
+                    excess = rule.condition == Condition::Above ? state.value - rule.threshold
+                                                                : rule.threshold - state.value;
+                    break;
+                }
+                case Condition::Rise:
+                case Condition::Fall: {
+                    int slot = historySlotFor(steadyUs, rule.window);
+                    double seconds = slot >= 0 ? (steadyUs - historyTimes[slot]) * 1e-6 : 0.0;
+                    // No rate until the source has existed for a whole window
+                    if (seconds <= 0.0 || !historyPresent[(size_t) slot * ruleList.size() + r]) {
+                        state.valid = false;
+                        break;
+                    }
+                    double counts;
+                    if (rule.source == Source::Pixels) {
+                        const uint16_t *older = history.data() + (size_t) slot * binned.size();
+                        bool fall = rule.condition == Condition::Fall;
+                        counts = fall ? -(double) maxRise(older, true) : (double) maxRise(older, false);
+                    } else {
+                        counts = currentValues[r] - historyValues[(size_t) slot * ruleList.size() + r];
+                    }
+                    state.value = counts / CountsPerKelvin / seconds;
+                    excess = rule.condition == Condition::Rise ? state.value - rule.threshold
+                                                               : -state.value - rule.threshold;
+                    break;
+                }
+                case Condition::Delta: {
+                    double reference;
+                    state.valid = sourceValue(rule.reference, rule.referenceRoiId, stats, rois, reference);
+                    state.value = (currentValues[r] - reference) / CountsPerKelvin;
+                    excess = state.value - rule.threshold;
+                    break;
+                }
+            }
+        }
+
+        if (!state.valid) {
+            state.pending = 0;
+            continue;
+        }
+
+        // Debounced transitions with hysteresis on the clearing side
+        bool disagrees = state.active ? excess < -rule.hysteresis : excess > 0.0;
+        state.pending = disagrees ? state.pending + 1 : 0;
+        if (state.pending >= std::max(rule.debounce, 1)) {
+            state.active = !state.active;
+            state.pending = 0;
+
+            AlarmEvent event;
+            event.timeMs = wallTimeMs;
+            event.rule = (int) r;
+            event.raised = state.active;
+            event.value = (float) state.value;
+            std::strncpy(event.name, rule.name.c_str(), sizeof(event.name) - 1);
+            eventLog.push(event);
+        }
+    }
+
+    // Sample the history at a fixed interval so the ring spans a known time
+    int newest = (historyHead - 1 + params.historySlots) % params.historySlots;
+    if (historyCount == 0 || steadyUs - historyTimes[newest] >= (int64_t) std::llround(params.historyInterval * 1e6)) {
+        historyTimes[historyHead] = steadyUs;
+        std::copy(currentValues.begin(), currentValues.end(), historyValues.begin() + (size_t) historyHead * ruleList.size());
+        std::copy(currentPresent.begin(), currentPresent.end(), historyPresent.begin() + (size_t) historyHead * ruleList.size());
+        if (needsPixels) std::copy(binned.begin(), binned.end(), history.begin() + (size_t) historyHead * binned.size());
+        historyHead = (historyHead + 1) % params.historySlots;
+        historyCount = std::min(historyCount + 1, params.historySlots);
+    }
+}
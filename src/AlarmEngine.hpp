@@ -0,0 +1,153 @@
+#ifndef ALARM_ENGINE_HPP
+#define ALARM_ENGINE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct FrameStats;
+class RoiAnalyzer;
+class ThermalCalibration;
+
+struct AlarmEvent {
+    uint64_t sequence = 0;
+    int64_t timeMs = 0;  // wall clock, ms since the Unix epoch
+    int rule = -1;       // index into AlarmEngine::rules()
+    bool raised = false; // false when the alarm cleared
+    float value = 0.0f;  // measured value at the transition, in the rule's unit
+    char name[32] = {};
+};
+
+// Fixed-size event ring with one writer and any number of lock-free readers. Each slot carries
+// a version (seqlock): readers copy the event and drop it if the slot was rewritten meanwhile,
+// so a slow reader misses old events instead of ever blocking the writer.
+class AlarmEventLog {
+public:
+    static const int Capacity = 256;
+
+    void push(AlarmEvent event);
+
+    // Sequence number the next event will get
+    uint64_t next() const { return head.load(std::memory_order_acquire); }
+
+    // Copies up to max events starting at sequence from; returns the sequence to continue from.
+    // Events already overwritten are skipped.
+    uint64_t read(uint64_t from, AlarmEvent *out, int max, int &count) const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> version{0}; // 2 * sequence + 1 while writing, + 2 when complete
+        AlarmEvent event;
+    };
+    Slot slots[Capacity];
+    std::atomic<uint64_t> head{0};
+};
+
+// Evaluates alarm rules once per frame. Sources are the frame statistics, measurement regions
+// and, for rates, a 2x2-binned copy of the plane. Absolute limits compare calibrated
+// temperatures; rates (dT/dt over a window) and deltas to a reference use apparent
+// temperature differences in K. A short ring of binned planes and source values, sampled at a
+// fixed interval, provides the history for the rates. Transitions are debounced, clear only
+// below the limit minus the hysteresis, and go to a lock-free event log.
+class AlarmEngine {
+public:
+    enum class Source {
+        FrameMax,
+        FrameMin,
+        FrameMean,
+        RoiMax,
+        RoiMin,
+        RoiMean,
+        Pixels // each 2x2 cell on its own; for limits the same as FrameMax/FrameMin
+    };
+
+    enum class Condition {
+        Above, // value > threshold (C)
+        Below, // value < threshold (C)
+        Rise,  // rate > threshold (K/s)
+        Fall,  // -rate > threshold (K/s)
+        Delta  // value - reference > threshold (K)
+    };
+
+    struct Rule {
+        std::string name;
+        Source source = Source::FrameMax;
+        int roiId = 0;
+        Condition condition = Condition::Above;
+        double threshold = 0.0;
+        double hysteresis = 0.5; // K (K/s for rates)
+        double window = 2.0;     // seconds, for rates
+        int debounce = 3;        // consecutive frames to raise or clear
+        Source reference = Source::FrameMean;
+        int referenceRoiId = 0;
+    };
+
+    struct RuleState {
+        bool active = false;
+        bool valid = false; // false while the source is missing or the history too short
+        double value = 0.0; // last evaluated value in the rule's unit
+        int pending = 0;    // consecutive frames disagreeing with the current state
+    };
+
+    struct Params {
+        int historySlots = 120;
+        double historyInterval = 0.25; // seconds between history samples; 30 s of history
+    };
+
+    AlarmEngine(int width, int height);
+
+    void setParams(const Params &p);
+    const Params &getParams() const { return params; }
+
+    void setRules(const std::vector<Rule> &rules);
+    const std::vector<Rule> &rules() const { return ruleList; }
+    const std::vector<RuleState> &states() const { return ruleStates; }
+
+    // Text rules, one per line: name source condition threshold [window=s] [hysteresis=K]
+    // [debounce=n] [reference=source]. Sources: frame.max, frame.min, frame.mean, pixels,
+    // roi:<id>.max|min|mean; conditions: above, below (C), rise, fall (K/s), delta (K).
+    // Lines starting with '#' are comments.
+    bool loadRules(const std::string &path);
+
+    // steadyUs times the rate windows and must come from a monotonic clock (e.g. the frame's
+    // capture time); wallTimeMs only stamps the events, so a clock step cannot distort rates
+    void evaluate(const uint16_t *y16, const FrameStats &stats, const RoiAnalyzer *rois,
+                  const ThermalCalibration &calibration, int64_t steadyUs, int64_t wallTimeMs);
+
+    // Forgets the history, e.g. after the camera reconnects; active alarms stay raised until
+    // they clear
+    void resetHistory();
+
+    const AlarmEventLog &events() const { return eventLog; }
+
+private:
+    int width;
+    int height;
+    int binnedWidth;
+    int binnedHeight;
+    Params params;
+    std::vector<Rule> ruleList;
+    std::vector<RuleState> ruleStates;
+    AlarmEventLog eventLog;
+
+    // History ring: binned planes and the raw source value of every rule, with whether the
+    // source existed when sampled (a region drawn later has no past to compare against)
+    std::vector<uint16_t> history;
+    std::vector<double> historyValues;
+    std::vector<uint8_t> historyPresent;
+    std::vector<int64_t> historyTimes; // steady clock, us
+    int historyHead = 0;
+    int historyCount = 0;
+    std::vector<uint16_t> binned;
+    std::vector<double> currentValues;
+    std::vector<uint8_t> currentPresent;
+    bool needsPixels = false;
+
+    bool sourceValue(Source source, int roiId, const FrameStats &stats, const RoiAnalyzer *rois,
+                     double &raw) const;
+    int historySlotFor(int64_t steadyUs, double window) const;
+    uint16_t maxRise(const uint16_t *older, bool fall) const;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "BadPixelAnalyzer.hpp"
+#include "BadPixelCorrector.hpp"
+#include <algorithm>
+#include <cmath>
+
+BadPixelAnalyzer::BadPixelAnalyzer(int width, int height)
+        : width(width), height(height), pending((size_t) width * height), sum((size_t) width * height),
+          sumSq((size_t) width * height) {}
+
+BadPixelAnalyzer::~BadPixelAnalyzer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void BadPixelAnalyzer::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    restart = true;
+    resultReady = false;
+    collected = 0;
+    running = true;
+    if (!worker.joinable()) {
+        worker = std::thread(&BadPixelAnalyzer::run, this);
+    }
+}
+
+void BadPixelAnalyzer::addFrame(const uint16_t *y16) {
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (framePending || collected >= params.frames) return;
+        std::copy(y16, y16 + pending.size(), pending.begin());
+        framePending = true;
+    }
+    cv.notify_one();
+}
+
+bool BadPixelAnalyzer::takeResult(std::vector<uint8_t> &flags) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!resultReady) return false;
+    resultReady = false;
+    flags = result;
+    return true;
+}
+
+void BadPixelAnalyzer::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return quit || framePending; });
+        if (quit) return;
+
+        if (restart) {
+            std::fill(sum.begin(), sum.end(), 0);
+            std::fill(sumSq.begin(), sumSq.end(), 0);
+            restart = false;
+        }
+
+        // pending is not touched by addFrame() while framePending is set
+        lock.unlock();
+        const size_t count = pending.size();
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t v = pending[i];
+            sum[i] += v;
+            sumSq[i] += v * v;
+        }
+        lock.lock();
+
+        framePending = false;
+        if (restart || ++collected < params.frames) continue;
+
+        lock.unlock();
+        classify();
+        lock.lock();
+        if (!restart) {
+            resultReady = true;
+            running = false;
+        }
+    }
+}
+
+void BadPixelAnalyzer::classify() {
+    const size_t count = (size_t) width * height;
+    const double n = params.frames;
+    std::vector<float> mean(count), noise(count);
+    for (size_t i = 0; i < count; ++i) {
+        double m = sum[i] / n;
+        mean[i] = (float) m;
+        noise[i] = (float) std::sqrt(std::max(sumSq[i] / n - m * m, 0.0));
+    }
+
+    std::vector<float> sorted = noise;
+    std::nth_element(sorted.begin(), sorted.begin() + count / 2, sorted.end());
+    const float medianNoise = sorted[count / 2];
+
+    result.assign(count, BadPixelCorrector::Good);
+    float neighbours[8];
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            size_t i = (size_t) y * width + x;
+            uint8_t flag = BadPixelCorrector::Good;
+
+            int k = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int px = x + dx, py = y + dy;
+                    if ((dx || dy) && px >= 0 && py >= 0 && px < width && py < height) {
+                        neighbours[k++] = mean[(size_t) py * width + px];
+                    }
+                }
+            }
+            std::nth_element(neighbours, neighbours + k / 2, neighbours + k);
+            float localMedian = neighbours[k / 2];
+
+            if (mean[i] < 1.0f || mean[i] > 65534.0f || std::fabs(mean[i] - localMedian) > params.deadThreshold) {
+                flag |= BadPixelCorrector::Dead;
+            }
+            // Stuck pixels only stand out when the sensor noise is measurable at all
+            if (medianNoise > 0.5f && noise[i] < params.stuckRatio * medianNoise) {
+                flag |= BadPixelCorrector::Stuck;
+            }
+            if (noise[i] > 2.0f && noise[i] > params.noisyRatio * medianNoise) {
+                flag |= BadPixelCorrector::Noisy;
+            }
+            result[i] = flag;
+        }
+    }
+}
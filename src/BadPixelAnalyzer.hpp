@@ -0,0 +1,62 @@
+#ifndef BAD_PIXEL_ANALYZER_HPP
+#define BAD_PIXEL_ANALYZER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Collects per-pixel temporal statistics on a background thread and classifies pixels as dead,
+// stuck or noisy (BadPixelCorrector flags). The capture loop only hands over frames with
+// addFrame(); frames arriving while the worker is busy are skipped.
+class BadPixelAnalyzer {
+public:
+    struct Params {
+        int frames = 200;            // frames per scan (8 s at 25 fps)
+        double deadThreshold = 320;  // counts (5 K) between a pixel's mean and its neighbours' median
+        double stuckRatio = 0.2;     // temporal noise below this fraction of the sensor median
+        double noisyRatio = 5.0;     // temporal noise above this multiple of the sensor median
+    };
+
+    BadPixelAnalyzer(int width, int height);
+    ~BadPixelAnalyzer();
+
+    void setParams(const Params &p) { params = p; }
+
+    // Starts a new scan, discarding one in progress
+    void start();
+    bool isRunning() const { return running; }
+    float progress() const { return (float) collected / (float) params.frames; }
+
+    void addFrame(const uint16_t *y16);
+
+    // Returns true once per finished scan with one flag byte per pixel
+    bool takeResult(std::vector<uint8_t> &flags);
+
+private:
+    int width;
+    int height;
+    Params params;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool quit = false;
+    bool restart = false;
+    bool framePending = false;
+    bool resultReady = false;
+    std::atomic<bool> running{false};
+    std::atomic<int> collected{0};
+
+    std::vector<uint16_t> pending;
+    std::vector<uint64_t> sum;
+    std::vector<uint64_t> sumSq;
+    std::vector<uint8_t> result;
+
+    void run();
+    void classify();
+};
+
+#endif
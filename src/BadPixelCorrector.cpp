@@ -0,0 +1,129 @@
+#include "BadPixelCorrector.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char MapMagic[4] = {'P', '2', 'B', 'P'};
+
+BadPixelCorrector::BadPixelCorrector(int width, int height)
+        : width(width), height(height), flags((size_t) width * height, Good) {}
+
+void BadPixelCorrector::clear() {
+    std::fill(flags.begin(), flags.end(), (uint8_t) Good);
+    target.clear();
+    n0.clear();
+    n1.clear();
+    n2.clear();
+    n3.clear();
+}
+
+int BadPixelCorrector::findGoodNeighbours(int x, int y, uint32_t *out) const {
+    auto good = [&](int px, int py) {
+        return px >= 0 && py >= 0 && px < width && py < height && flags[(size_t) py * width + px] == Good;
+    };
+
+    // Nearest good pixel in each of the four directions, so lines and small clusters still
+    // interpolate across both axes
+    static const int dirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    int found = 0;
+    for (const auto &d: dirs) {
+        for (int r = 1; r <= 4; ++r) {
+            int px = x + d[0] * r, py = y + d[1] * r;
+            if (good(px, py)) {
+                out[found++] = (uint32_t) (py * width + px);
+                break;
+            }
+        }
+    }
+
+    // Larger clusters: any good pixel on growing rings
+    for (int r = 1; found == 0 && r <= 8; ++r) {
+        for (int dy = -r; dy <= r && found < 4; ++dy) {
+            for (int dx = -r; dx <= r && found < 4; ++dx) {
+                if ((dx == -r || dx == r || dy == -r || dy == r) && good(x + dx, y + dy)) {
+                    out[found++] = (uint32_t) ((y + dy) * width + x + dx);
+                }
+            }
+        }
+    }
+    return found;
+}
+
+void BadPixelCorrector::setMap(const std::vector<uint8_t> &newFlags) {
+    if (newFlags.size() != flags.size()) return;
+    flags = newFlags;
+    target.clear();
+    n0.clear();
+    n1.clear();
+    n2.clear();
+    n3.clear();
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (flags[(size_t) y * width + x] == Good) continue;
+            uint32_t n[4];
+            int found = findGoodNeighbours(x, y, n);
+            if (found == 0) continue; // nothing usable nearby, leave as is
+
+            // Repeat neighbours so every entry averages exactly four values
+            for (int i = found; i < 4; ++i) n[i] = n[i % found];
+            target.push_back((uint32_t) (y * width + x));
+            n0.push_back(n[0]);
+            n1.push_back(n[1]);
+            n2.push_back(n[2]);
+            n3.push_back(n[3]);
+        }
+    }
+}
+
+void BadPixelCorrector::apply(uint16_t *y16) const {
+    const uint32_t *t = target.data();
+    const uint32_t *a = n0.data();
+    const uint32_t *b = n1.data();
+    const uint32_t *c = n2.data();
+    const uint32_t *d = n3.data();
+    const int count = (int) target.size();
+    for (int i = 0; i < count; ++i) {
+        y16[t[i]] = (uint16_t) (((uint32_t) y16[a[i]] + y16[b[i]] + y16[c[i]] + y16[d[i]] + 2) >> 2);
+    }
+}
+
+bool BadPixelCorrector::save(const std::string &path) const {
+    if (path.empty()) return false;
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    uint32_t header[3] = {(uint32_t) width, (uint32_t) height, 0};
+    for (uint8_t flag: flags) header[2] += flag != Good;
+    bool ok = std::fwrite(MapMagic, 1, 4, f) == 4 && std::fwrite(header, sizeof(header), 1, f) == 1;
+    for (size_t i = 0; ok && i < flags.size(); ++i) {
+        if (flags[i] == Good) continue;
+        uint32_t index = (uint32_t) i;
+        ok = std::fwrite(&index, sizeof(index), 1, f) == 1 && std::fwrite(&flags[i], 1, 1, f) == 1;
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+bool BadPixelCorrector::load(const std::string &path) {
+    if (path.empty()) return false;
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char magic[4];
+    uint32_t header[3];
+    bool ok = std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, MapMagic, 4) == 0 &&
+              std::fread(header, sizeof(header), 1, f) == 1 &&
+              header[0] == (uint32_t) width && header[1] == (uint32_t) height;
+
+    std::vector<uint8_t> loaded(flags.size(), Good);
+    for (uint32_t i = 0; ok && i < header[2]; ++i) {
+        uint32_t index;
+        uint8_t flag;
+        ok = std::fread(&index, sizeof(index), 1, f) == 1 && std::fread(&flag, 1, 1, f) == 1 && index < loaded.size();
+        if (ok) loaded[index] = flag;
+    }
+    std::fclose(f);
+
+    if (ok) setMap(loaded);
+    return ok;
+}
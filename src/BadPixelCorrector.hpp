@@ -0,0 +1,44 @@
+#ifndef BAD_PIXEL_CORRECTOR_HPP
+#define BAD_PIXEL_CORRECTOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Replaces flagged sensor pixels with the average of four good neighbours. The neighbour
+// indices are resolved once when the map is set; since they always point at good pixels the
+// per-frame pass is a branch-free gather over the short list of bad pixels.
+class BadPixelCorrector {
+public:
+    enum Flag : uint8_t {
+        Good = 0,
+        Dead = 1,  // far off its neighbourhood or pinned at a rail
+        Stuck = 2, // does not follow the sensor noise
+        Noisy = 4  // much noisier than the rest of the sensor
+    };
+
+    BadPixelCorrector(int width, int height);
+
+    // One flag byte per pixel, 0 = good
+    void setMap(const std::vector<uint8_t> &flags);
+    const std::vector<uint8_t> &getMap() const { return flags; }
+    int badCount() const { return (int) target.size(); }
+    void clear();
+
+    // Binary map files as kept per device serial (see DeviceStorage)
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+    void apply(uint16_t *y16) const;
+
+private:
+    int width;
+    int height;
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> target;
+    std::vector<uint32_t> n0, n1, n2, n3;
+
+    int findGoodNeighbours(int x, int y, uint32_t *out) const;
+};
+
+#endif
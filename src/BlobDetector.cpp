@@ -0,0 +1,153 @@
+#include "BlobDetector.hpp"
+#include <algorithm>
+
+BlobDetector::BlobDetector(int width, int height) : width(width), height(height) {
+    // Worst case is a checkerboard-like row: one run for every other pixel
+    size_t maxRuns = (size_t) height * ((width + 1) / 2);
+    runs.reserve(maxRuns);
+    rowStart.resize(height + 1);
+    parent.resize(maxRuns);
+    blobOfRun.resize(maxRuns);
+    scratch.reserve(maxRuns);
+    sumX.reserve(maxRuns);
+    sumY.reserve(maxRuns);
+    sumV.reserve(maxRuns);
+    result.reserve(maxRuns);
+}
+
+int BlobDetector::find(int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void BlobDetector::detect(const uint16_t *y16, const FrameStats &stats) {
+    result.clear();
+    if (stats.empty()) return;
+
+    int mean = (int) (stats.mean() + 0.5);
+    int hot = params.hotThreshold > 0 ? params.hotThreshold : mean + params.hotDelta;
+    if (hot <= 65535 && stats.max >= hot) {
+        label<false>(y16, (uint16_t) hot);
+    }
+
+    int cold = mean - params.coldDelta;
+    if (params.detectCold && cold >= 0 && stats.min <= cold) {
+        label<true>(y16, (uint16_t) cold);
+    }
+}
+
+template<bool Cold>
+void BlobDetector::label(const uint16_t *y16, uint16_t threshold) {
+    auto passes = [threshold](uint16_t v) { return Cold ? v <= threshold : v >= threshold; };
+
+    // Pass 1: runs per row, with their sum and extreme value
+    runs.clear();
+    for (int y = 0; y < height; ++y) {
+        rowStart[y] = (int) runs.size();
+        const uint16_t *row = y16 + (size_t) y * width;
+        int x = 0;
+        while (x < width) {
+            while (x < width && !passes(row[x])) x++;
+            if (x >= width) break;
+
+            Run r = {y, x, x, 0, row[x], x};
+            for (; x < width && passes(row[x]); ++x) {
+                uint16_t v = row[x];
+                r.sum += v;
+                if (Cold ? v < r.peak : v > r.peak) {
+                    r.peak = v;
+                    r.peakX = x;
+                }
+            }
+            r.x1 = x - 1;
+            runs.push_back(r);
+        }
+    }
+    rowStart[height] = (int) runs.size();
+
+    int runCount = (int) runs.size();
+    for (int i = 0; i < runCount; ++i) parent[i] = i;
+
+    // Pass 2: merge runs that overlap a run of the previous row, including diagonally
+    for (int y = 1; y < height; ++y) {
+        int j = rowStart[y - 1];
+        int prevEnd = rowStart[y];
+        for (int i = rowStart[y]; i < rowStart[y + 1]; ++i) {
+            while (j < prevEnd && runs[j].x1 < runs[i].x0 - 1) j++;
+            for (int k = j; k < prevEnd && runs[k].x0 <= runs[i].x1 + 1; ++k) {
+                int a = find(i);
+                int b = find(k);
+                if (a != b) {
+                    // The lower index stays root so roots always come before their members
+                    if (a < b) parent[b] = a;
+                    else parent[a] = b;
+                }
+            }
+        }
+    }
+
+    // Pass 3: accumulate each component
+    scratch.clear();
+    sumX.clear();
+    sumY.clear();
+    sumV.clear();
+    for (int i = 0; i < runCount; ++i) {
+        const Run &r = runs[i];
+        int root = find(i);
+        if (root == i) {
+            blobOfRun[i] = (int) scratch.size();
+            Blob b;
+            b.cold = Cold;
+            b.minX = r.x0;
+            b.maxX = r.x1;
+            b.minY = b.maxY = r.y;
+            b.peak = r.peak;
+            b.peakX = r.peakX;
+            b.peakY = r.y;
+            scratch.push_back(b);
+            sumX.push_back(0.0);
+            sumY.push_back(0.0);
+            sumV.push_back(0.0);
+        } else {
+            blobOfRun[i] = blobOfRun[root];
+        }
+
+        int idx = blobOfRun[i];
+        Blob &b = scratch[idx];
+        int len = r.x1 - r.x0 + 1;
+        b.area += len;
+        b.minX = std::min(b.minX, r.x0);
+        b.maxX = std::max(b.maxX, r.x1);
+        b.minY = std::min(b.minY, r.y);
+        b.maxY = std::max(b.maxY, r.y);
+        if (Cold ? r.peak < b.peak : r.peak > b.peak) {
+            b.peak = r.peak;
+            b.peakX = r.peakX;
+            b.peakY = r.y;
+        }
+        sumX[idx] += len * (r.x0 + r.x1) * 0.5;
+        sumY[idx] += (double) len * r.y;
+        sumV[idx] += r.sum;
+    }
+
+    // Drop noise, finish the averages and keep the most extreme blobs
+    size_t first = result.size();
+    for (size_t i = 0; i < scratch.size(); ++i) {
+        Blob &b = scratch[i];
+        if (b.area < params.minArea) continue;
+        b.cx = (float) (sumX[i] / b.area);
+        b.cy = (float) (sumY[i] / b.area);
+        b.meanRaw = (float) (sumV[i] / b.area);
+        result.push_back(b);
+    }
+
+    auto begin = result.begin() + first;
+    size_t keep = std::min(result.size() - first, (size_t) std::max(params.maxBlobs, 0));
+    std::partial_sort(begin, begin + keep, result.end(), [](const Blob &a, const Blob &b) {
+        return Cold ? a.peak < b.peak : a.peak > b.peak;
+    });
+    result.resize(first + keep);
+}
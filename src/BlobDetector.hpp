@@ -0,0 +1,73 @@
+#ifndef BLOB_DETECTOR_HPP
+#define BLOB_DETECTOR_HPP
+
+#include <cstdint>
+#include <vector>
+#include "FrameStats.hpp"
+
+// Connected region of pixels above the hot threshold (or below the cold threshold)
+struct Blob {
+    bool cold = false;
+    int area = 0;
+    int minX = 0, minY = 0, maxX = 0, maxY = 0; // bounding box, inclusive
+    float cx = 0.0f, cy = 0.0f;                 // centroid
+    uint16_t peak = 0;                          // hottest (coldest for cold blobs) raw value
+    int peakX = 0, peakY = 0;
+    float meanRaw = 0.0f;
+    int trackId = -1;                           // assigned by BlobTracker
+};
+
+// Finds every hot and cold region of a Y16 frame. Each row is split into runs of pixels that
+// pass the threshold and runs touching the previous row's runs (8-connected) are merged with
+// union-find, so labelling costs one pass over the pixels plus one over the runs. All buffers
+// are sized for the worst case up front; detect() does not allocate. One detector per camera.
+class BlobDetector {
+public:
+    struct Params {
+        int hotDelta = 128;   // raw counts above the frame mean (128 = 2 K)
+        int coldDelta = 128;  // raw counts below the frame mean
+        int hotThreshold = 0; // absolute raw threshold overriding hotDelta, 0 = relative
+        int minArea = 4;      // smaller regions are treated as noise
+        int maxBlobs = 16;    // per polarity, hottest/coldest first
+        bool detectCold = true;
+    };
+
+    BlobDetector(int width, int height);
+
+    void setParams(const Params &p) { params = p; }
+    const Params &getParams() const { return params; }
+
+    // Thresholds are taken relative to the frame mean from stats
+    void detect(const uint16_t *y16, const FrameStats &stats);
+    void clear() { result.clear(); }
+
+    // Hot blobs (hottest first) followed by cold blobs (coldest first)
+    const std::vector<Blob> &blobs() const { return result; }
+
+private:
+    struct Run {
+        int y;
+        int x0, x1; // inclusive
+        uint32_t sum;
+        uint16_t peak;
+        int peakX;
+    };
+
+    int width;
+    int height;
+    Params params;
+    std::vector<Run> runs;
+    std::vector<int> rowStart; // first run of each row, rowStart[height] = run count
+    std::vector<int> parent;
+    std::vector<int> blobOfRun;
+    std::vector<Blob> scratch;
+    std::vector<double> sumX, sumY, sumV;
+    std::vector<Blob> result;
+
+    template<bool Cold>
+    void label(const uint16_t *y16, uint16_t threshold);
+
+    int find(int i);
+};
+
+#endif
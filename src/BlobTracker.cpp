@@ -0,0 +1,133 @@
+#include "BlobTracker.hpp"
+#include <algorithm>
+
+BlobTracker::BlobTracker() {
+    output.reserve(MaxTracks);
+}
+
+void BlobTracker::clear() {
+    for (Track &t: tracks) t.active = false;
+    output.clear();
+}
+
+void BlobTracker::predict(Track &t) const {
+    // x' = F x, P' = F P F^T + Q with F = [1 1; 0 1] and Q for a white noise acceleration
+    const float q = params.processNoise;
+    t.x += t.vx;
+    t.y += t.vy;
+    t.p00 += 2.0f * t.p01 + t.p11 + 0.25f * q;
+    t.p01 += t.p11 + 0.5f * q;
+    t.p11 += q;
+}
+
+void BlobTracker::correct(Track &t, const Blob &b) const {
+    const float s = t.p00 + params.measureNoise;
+    const float k0 = t.p00 / s;
+    const float k1 = t.p01 / s;
+
+    float ex = b.cx - t.x;
+    float ey = b.cy - t.y;
+    t.x += k0 * ex;
+    t.y += k0 * ey;
+    t.vx += k1 * ex;
+    t.vy += k1 * ey;
+
+    t.p11 -= k1 * t.p01;
+    t.p00 *= 1.0f - k0;
+    t.p01 *= 1.0f - k0;
+
+    // The box size is only used for matching, so follow it with a simple average
+    t.halfW += 0.5f * ((b.maxX - b.minX + 1) * 0.5f - t.halfW);
+    t.halfH += 0.5f * ((b.maxY - b.minY + 1) * 0.5f - t.halfH);
+}
+
+void BlobTracker::start(const Blob &b) {
+    for (Track &t: tracks) {
+        if (t.active) continue;
+        t = Track();
+        t.active = true;
+        t.id = nextId++;
+        t.cold = b.cold;
+        t.x = b.cx;
+        t.y = b.cy;
+        t.p00 = params.measureNoise;
+        t.p11 = 4.0f; // unknown initial velocity, a few px/frame
+        t.halfW = (b.maxX - b.minX + 1) * 0.5f;
+        t.halfH = (b.maxY - b.minY + 1) * 0.5f;
+        t.hits = 1;
+        return;
+    }
+    // Pool full: the blob stays untracked until a slot frees up
+}
+
+void BlobTracker::update(const std::vector<Blob> &detections) {
+    const int detectionCount = std::min((int) detections.size(), MaxTracks);
+
+    for (Track &t: tracks) {
+        if (!t.active) continue;
+        predict(t);
+        t.detection = -1;
+    }
+
+    // Score every track/detection pair of the same polarity by the overlap of the predicted box
+    int candidateCount = 0;
+    for (int ti = 0; ti < MaxTracks; ++ti) {
+        const Track &t = tracks[ti];
+        if (!t.active) continue;
+        float tx0 = t.x - t.halfW - params.boxMargin, tx1 = t.x + t.halfW + params.boxMargin;
+        float ty0 = t.y - t.halfH - params.boxMargin, ty1 = t.y + t.halfH + params.boxMargin;
+        float trackArea = (tx1 - tx0) * (ty1 - ty0);
+
+        for (int di = 0; di < detectionCount; ++di) {
+            const Blob &b = detections[di];
+            if (b.cold != t.cold) continue;
+            float bx0 = (float) b.minX, bx1 = (float) b.maxX + 1.0f;
+            float by0 = (float) b.minY, by1 = (float) b.maxY + 1.0f;
+            float iw = std::min(tx1, bx1) - std::max(tx0, bx0);
+            float ih = std::min(ty1, by1) - std::max(ty0, by0);
+            if (iw <= 0 || ih <= 0) continue;
+            float inter = iw * ih;
+            float iou = inter / (trackArea + (bx1 - bx0) * (by1 - by0) - inter);
+            if (iou >= params.minIoU) {
+                candidates[candidateCount++] = {iou, (int16_t) ti, (int16_t) di};
+            }
+        }
+    }
+
+    // Greedy assignment, best overlap first
+    std::sort(candidates.begin(), candidates.begin() + candidateCount,
+              [](const Candidate &a, const Candidate &b) { return a.iou > b.iou; });
+    detectionUsed.fill(false);
+    for (int i = 0; i < candidateCount; ++i) {
+        const Candidate &c = candidates[i];
+        Track &t = tracks[c.track];
+        if (t.detection >= 0 || detectionUsed[c.detection]) continue;
+        t.detection = c.detection;
+        detectionUsed[c.detection] = true;
+    }
+
+    for (Track &t: tracks) {
+        if (!t.active) continue;
+        if (t.detection >= 0) {
+            correct(t, detections[t.detection]);
+            t.hits++;
+            t.misses = 0;
+        } else if (++t.misses > params.maxMisses) {
+            t.active = false;
+        }
+    }
+
+    for (int di = 0; di < detectionCount; ++di) {
+        if (!detectionUsed[di]) start(detections[di]);
+    }
+
+    output.clear();
+    for (const Track &t: tracks) {
+        if (!t.active || t.detection < 0 || t.hits < params.confirmHits) continue;
+        Blob b = detections[t.detection];
+        b.trackId = t.id;
+        b.cx = t.x;
+        b.cy = t.y;
+        output.push_back(b);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef BLOB_TRACKER_HPP
+#define BLOB_TRACKER_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "BlobDetector.hpp"
+
+// Follows the blobs of one stream across frames and gives each a stable ID. Every track runs a
+// constant-velocity Kalman filter on its centroid; detections are matched to the predicted boxes
+// by greedy IoU, so a blob that briefly merges with or passes another keeps its ID while it
+// coasts on its velocity. Tracks live in a fixed pool and update() does not allocate.
+class BlobTracker {
+public:
+    static constexpr int MaxTracks = 64;
+
+    struct Params {
+        float minIoU = 0.1f;        // weakest overlap accepted as the same target
+        float boxMargin = 2.0f;     // predicted boxes are grown by this many pixels when matching
+        float processNoise = 0.5f;  // acceleration variance, px^2/frame^4
+        float measureNoise = 1.0f;  // centroid variance, px^2
+        int confirmHits = 2;        // detections before a track is reported
+        int maxMisses = 5;          // frames a track coasts without a detection
+    };
+
+    BlobTracker();
+
+    void setParams(const Params &p) { params = p; }
+    const Params &getParams() const { return params; }
+
+    // Advances all tracks by one frame and matches them to the detections
+    void update(const std::vector<Blob> &detections);
+    void clear();
+
+    // Detections of confirmed tracks with trackId set and the centroid replaced by the filtered one
+    const std::vector<Blob> &tracked() const { return output; }
+
+private:
+    // Position and velocity along one axis with their covariance; both axes share the noise
+    // model so one covariance serves x and y
+    struct Track {
+        bool active = false;
+        int id = 0;
+        bool cold = false;
+        float x = 0, vx = 0;
+        float y = 0, vy = 0;
+        float p00 = 0, p01 = 0, p11 = 0;
+        float halfW = 0, halfH = 0;
+        int hits = 0;
+        int misses = 0;
+        int detection = -1; // index of this frame's detection, -1 when coasting
+    };
+
+    struct Candidate {
+        float iou;
+        int16_t track;
+        int16_t detection;
+    };
+
+    Params params;
+    std::array<Track, MaxTracks> tracks;
+    std::array<Candidate, MaxTracks * MaxTracks> candidates;
+    std::array<bool, MaxTracks> detectionUsed;
+    std::vector<Blob> output;
+    int nextId = 1;
+
+    void predict(Track &t) const;
+    void correct(Track &t, const Blob &b) const;
+    void start(const Blob &b);
+};
+
+#endif
@@ -1,19 +1,45 @@
 #include "CameraWindow.hpp"
 #include "P2Pro.hpp"
 #include "Icons.hpp"
+#include "ThreadPool.hpp"
 #include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    struct HeatmapMode {
+        PixelStatsAccumulator::Statistic statistic;
+        const char *name;
+    };
+
+    // Cycled with 'm'; entry 0 shows the live image
+    const HeatmapMode heatmapModes[] = {
+            {PixelStatsAccumulator::Statistic::Mean, "off"},
+            {PixelStatsAccumulator::Statistic::Max, "max"},
+            {PixelStatsAccumulator::Statistic::StdDev, "std dev"},
+            {PixelStatsAccumulator::Statistic::Range, "range"},
+            {PixelStatsAccumulator::Statistic::TimeOfMax, "time of max"},
+            {PixelStatsAccumulator::Statistic::Mean, "mean"},
+    };
+    const int HeatmapModeCount = (int) (sizeof(heatmapModes) / sizeof(heatmapModes[0]));
+}
 
 CameraWindow::CameraWindow(const std::string& title, int width, int height)
     : title(title), baseWidth(width), baseHeight(height), currentWidth(width), currentHeight(height),
-      scaler(width, height) {
+      scaler(width, height), detailEnhancer(width, height), upscaler(SensorWidth, SensorHeight) {
 }
 
 CameraWindow::~CameraWindow() {
     cleanupIcons();
+    text.release();
     if (font) TTF_CloseFont(font);
     TTF_Quit();
     if (texture) SDL_DestroyTexture(texture);
+    if (upscaledTexture) SDL_DestroyTexture(upscaledTexture);
+    if (legendTexture) SDL_DestroyTexture(legendTexture);
+    if (gradientTexture) SDL_DestroyTexture(gradientTexture);
     if (crosshairCursor) SDL_FreeCursor(crosshairCursor);
     if (defaultCursor) SDL_FreeCursor(defaultCursor);
     if (renderer) SDL_DestroyRenderer(renderer);
@@ -69,6 +95,9 @@ bool CameraWindow::init() {
 
     // Initialize icons
     initIcons();
+    if (font && !text.init(renderer, font)) {
+        dprintf("CameraWindow::init() - Warning: Could not build the glyph atlas. Text rendering will be disabled.\n");
+    }
 
     // Set initial window size
     currentWidth = (int)(baseWidth * currentScale);
@@ -78,12 +107,15 @@ bool CameraWindow::init() {
     SDL_RenderSetLogicalSize(renderer, currentWidth, currentHeight + toolbarHeight);
     SDL_ShowWindow(window);
 
+    wakeEvent = SDL_RegisterEvents(1);
+
     // Create cursors
     defaultCursor = SDL_GetDefaultCursor();
     crosshairCursor = SDL_CreateSystemCursor(SDL_SYSTEM_CURSOR_CROSSHAIR);
 
     dprintf("CameraWindow::init() - Creating texture...\n");
-    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING, baseWidth, baseHeight);
+    // The texture stays in sensor orientation; rotation is applied when it is drawn
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING, SensorWidth, SensorHeight);
     if (!texture) {
         dprintf("Texture could not be created! SDL_Error: %s\n", SDL_GetError());
         return false;
@@ -105,34 +137,75 @@ void CameraWindow::setScale(float scale) {
 
     SDL_SetWindowSize(window, currentWidth, currentHeight + toolbarHeight);
     SDL_RenderSetLogicalSize(renderer, currentWidth, currentHeight + toolbarHeight);
+    dirtyLayers = LayerAll;
 }
 
 float CameraWindow::getScale() const {
     return currentScale;
 }
 
+void CameraWindow::setDetailEnhancement(bool enabled) {
+    detailEnhancement = enabled;
+    dirtyLayers = LayerAll;
+    dprintf("CameraWindow - Detail enhancement %s\n", enabled ? "on" : "off");
+}
+
+void CameraWindow::setZoom(int level) {
+    int vx = currentWidth / 2;
+    int vy = toolbarHeight + currentHeight / 2;
+    zoomAt(level, vx, vy);
+}
+
+void CameraWindow::zoomAt(int level, int vx, int vy) {
+    int next = 1;
+    while (next < level && next < MaxZoom) next *= 2;
+    if (next == zoom) return;
+
+    // Keep the display point under (vx, vy) in place
+    SDL_FPoint anchor = viewToDisplay((float) vx, (float) vy);
+    float fx = (float) vx / (float) currentWidth;
+    float fy = (float) (vy - toolbarHeight) / (float) currentHeight;
+    zoom = next;
+    viewX = (int) std::lround(anchor.x - fx * viewWidth());
+    viewY = (int) std::lround(anchor.y - fy * viewHeight());
+    clampViewport();
+    dirtyLayers = LayerAll;
+}
+
+void CameraWindow::clampViewport() {
+    viewX = std::min(std::max(viewX, 0), baseWidth - viewWidth());
+    viewY = std::min(std::max(viewY, 0), baseHeight - viewHeight());
+}
+
+void CameraWindow::setUpscaleMethod(ThermalUpscaler::Method method) {
+    upscaleMethod = method;
+    dirtyLayers = LayerAll;
+    dprintf("CameraWindow - Upscaling: %s\n", ThermalUpscaler::methodName(method));
+}
+
 void CameraWindow::setRotation(int degrees) {
-    rotation = degrees % 360;
+    // The viewport follows the sensor pixel at its centre through the rotation
+    SDL_FPoint centre = displayToSensor(viewX + viewWidth() * 0.5f - 0.5f, viewY + viewHeight() * 0.5f - 0.5f);
 
-    // Update base dimensions based on rotation
-    int origW = 256;
-    int origH = 192;
+    rotation = degrees % 360;
 
+    // Update base dimensions based on rotation; the frame texture itself is unchanged
     if (rotation == 90 || rotation == 270) {
-        baseWidth = origH;
-        baseHeight = origW;
+        baseWidth = SensorHeight;
+        baseHeight = SensorWidth;
     } else {
-        baseWidth = origW;
-        baseHeight = origH;
+        baseWidth = SensorWidth;
+        baseHeight = SensorHeight;
     }
 
-    // Recreate texture with new dimensions
-    if (texture) SDL_DestroyTexture(texture);
-    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING, baseWidth, baseHeight);
-
     // Update scaler
     scaler = Scaler(baseWidth, baseHeight);
 
+    centre = sensorToDisplay(centre.x, centre.y);
+    viewX = (int) std::lround(centre.x + 0.5f - viewWidth() * 0.5f);
+    viewY = (int) std::lround(centre.y + 0.5f - viewHeight() * 0.5f);
+    clampViewport();
+
     // Maintain current scale factor
     currentWidth = (int) std::round(baseWidth * currentScale);
     currentHeight = (int) std::round(baseHeight * currentScale);
@@ -140,12 +213,46 @@ void CameraWindow::setRotation(int degrees) {
     SDL_SetWindowSize(window, currentWidth, currentHeight + toolbarHeight);
     SDL_RenderSetLogicalSize(renderer, currentWidth, currentHeight + toolbarHeight);
     SDL_SetWindowMinimumSize(window, (int)(baseWidth * 0.5f), (int)(baseHeight * 0.5f) + toolbarHeight);
+    dirtyLayers = LayerAll;
+}
+
+void CameraWindow::invalidate() {
+    dirtyLayers = LayerAll;
+}
+
+void CameraWindow::waitForEvents(int timeoutMs) {
+    SDL_WaitEventTimeout(nullptr, timeoutMs);
+}
+
+void CameraWindow::wake() {
+    if (wakeEvent == (Uint32) -1) return;
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = wakeEvent;
+    SDL_PushEvent(&e);
 }
 
 void CameraWindow::pollEvents(bool& running, bool& recordToggleRequested) {
     SDL_Event e;
     recordToggleRequested = false;
     while (SDL_PollEvent(&e) != 0) {
+        // Only there to end waitForEvents(); a new frame marks its own layers in updateFrame()
+        if (wakeEvent != (Uint32) -1 && e.type == wakeEvent) continue;
+
+        // Pointer motion only matters to the tooltip and a region being dragged; anything else
+        // (keys, clicks, window changes) is rare enough to simply redraw everything
+        if (e.type == SDL_MOUSEMOTION) {
+            if (showMouseTemp) dirtyLayers |= LayerTooltip;
+            if (roiDragging) dirtyLayers |= LayerOverlay;
+            if (panning) dirtyLayers = LayerAll;
+        } else {
+            dirtyLayers = LayerAll;
+        }
+
+        // Input may edit the regions or the calibration's unit, which the capture thread reads
+        std::unique_lock<std::mutex> lock;
+        if (e.type != SDL_MOUSEMOTION) lock = lockAnalysis();
+
         if (e.type == SDL_QUIT) {
             running = false;
         } else if (e.type == SDL_MOUSEMOTION) {
@@ -154,8 +261,93 @@ void CameraWindow::pollEvents(bool& running, bool& recordToggleRequested) {
             
             // Record button in toolbar is at x around 100
             mouseOverRecordButton = (mouseY < toolbarHeight && mouseX > 80 && mouseX < 120);
+
+            if (roiDragging) {
+                roiDragEnd = viewToRoi(mouseX, mouseY);
+            }
+            if (panning) {
+                // Whole display pixels, so the view snaps to the sensor grid while dragging
+                viewX = panViewX - (int) std::lround((mouseX - panStartX) * (float) viewWidth() / (float) currentWidth);
+                viewY = panViewY - (int) std::lround((mouseY - panStartY) * (float) viewHeight() / (float) currentHeight);
+                clampViewport();
+            }
+        } else if (e.type == SDL_MOUSEWHEEL) {
+            int steps = e.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -e.wheel.y : e.wheel.y;
+            if (mouseY >= toolbarHeight && steps != 0) {
+                zoomAt(steps > 0 ? zoom * 2 : zoom / 2, mouseX, mouseY);
+            }
+        } else if (e.type == SDL_KEYDOWN) {
+            if (e.key.keysym.sym == SDLK_d) {
+                setDetailEnhancement(!detailEnhancement);
+            } else if (e.key.keysym.sym == SDLK_i) {
+                setUpscaleMethod((ThermalUpscaler::Method) (((int) upscaleMethod + 1) % 4));
+            } else if (e.key.keysym.sym == SDLK_0) {
+                setZoom(1);
+            } else if (e.key.keysym.sym == SDLK_LEFT || e.key.keysym.sym == SDLK_RIGHT) {
+                viewX += (e.key.keysym.sym == SDLK_LEFT ? -1 : 1) * std::max(1, viewWidth() / 4);
+                clampViewport();
+            } else if (e.key.keysym.sym == SDLK_UP || e.key.keysym.sym == SDLK_DOWN) {
+                viewY += (e.key.keysym.sym == SDLK_UP ? -1 : 1) * std::max(1, viewHeight() / 4);
+                clampViewport();
+            } else if (e.key.keysym.sym == SDLK_l) {
+                showLegend = !showLegend;
+            } else if (e.key.keysym.sym == SDLK_b) {
+                showBlobs = !showBlobs;
+            } else if (e.key.keysym.sym == SDLK_h && metrics) {
+                showMetrics = !showMetrics;
+                // Start the first window now so it does not cover the whole time the HUD was off
+                metricsSummary = PipelineMetrics::Summary();
+                metricsRefreshUs = PipelineMetrics::nowUs();
+                if (showMetrics) metrics->summarize();
+            } else if (e.key.keysym.sym == SDLK_p) {
+                badPixelScanRequested = true;
+            } else if (e.key.keysym.sym == SDLK_f) {
+                flatFieldRequested = true;
+            } else if (e.key.keysym.sym == SDLK_m && pixelStats) {
+                heatmapMode = (heatmapMode + 1) % HeatmapModeCount;
+            } else if (e.key.keysym.sym == SDLK_BACKSPACE && roiAnalyzer) {
+                roiAnalyzer->clear();
+                polygonDraft.clear();
+                roiDragging = false;
+            } else if (e.key.keysym.sym == SDLK_u && calibration) {
+                TemperatureUnit next = calibration->getUnit() == TemperatureUnit::Celsius ? TemperatureUnit::Fahrenheit
+                                     : calibration->getUnit() == TemperatureUnit::Fahrenheit ? TemperatureUnit::Kelvin
+                                     : TemperatureUnit::Celsius;
+                calibration->setUnit(next);
+            }
+        } else if (e.type == SDL_KEYUP) {
+            if ((e.key.keysym.sym == SDLK_LCTRL || e.key.keysym.sym == SDLK_RCTRL) && roiAnalyzer) {
+                if (polygonDraft.size() >= 3) roiAnalyzer->addPolygon(polygonDraft);
+                polygonDraft.clear();
+            }
+        } else if (e.type == SDL_MOUSEBUTTONUP) {
+            if (e.button.button == SDL_BUTTON_MIDDLE) {
+                panning = false;
+            } else if (e.button.button == SDL_BUTTON_RIGHT && roiDragging) {
+                roiDragging = false;
+                roiDragEnd = viewToRoi(e.button.x, e.button.y);
+                if (std::fabs(roiDragEnd.x - roiDragStart.x) >= 1.0f && std::fabs(roiDragEnd.y - roiDragStart.y) >= 1.0f) {
+                    if (SDL_GetModState() & KMOD_SHIFT) roiAnalyzer->addEllipse(roiDragStart, roiDragEnd);
+                    else roiAnalyzer->addRectangle(roiDragStart, roiDragEnd);
+                }
+            }
         } else if (e.type == SDL_MOUSEBUTTONDOWN) {
-            if (e.button.button == SDL_BUTTON_LEFT) {
+            if (e.button.button == SDL_BUTTON_MIDDLE && e.button.y >= toolbarHeight && zoom > 1) {
+                panning = true;
+                panStartX = e.button.x;
+                panStartY = e.button.y;
+                panViewX = viewX;
+                panViewY = viewY;
+            } else if (e.button.button == SDL_BUTTON_RIGHT && roiAnalyzer && e.button.y >= toolbarHeight) {
+                RoiPoint p = viewToRoi(e.button.x, e.button.y);
+                if (SDL_GetModState() & KMOD_CTRL) {
+                    polygonDraft.push_back(p);
+                } else {
+                    roiDragging = true;
+                    roiDragStart = p;
+                    roiDragEnd = p;
+                }
+            } else if (e.button.button == SDL_BUTTON_LEFT) {
                 if (mouseY < toolbarHeight) {
                     // Toolbar interaction
                     // Icon centers: 25, 65, 100, 135, 175, 215. Each hit area approx 35-40px.
@@ -184,6 +376,9 @@ void CameraWindow::pollEvents(bool& running, bool& recordToggleRequested) {
                     SDL_SetCursor(showMouseTemp ? crosshairCursor : defaultCursor);
                 }
             }
+        } else if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+            // Render target contents are lost with the device
+            legendStale = true;
         } else if (e.type == SDL_WINDOWEVENT) {
             if (e.window.event == SDL_WINDOWEVENT_RESIZED) {
                 int newW = e.window.data1;
@@ -204,62 +399,120 @@ void CameraWindow::pollEvents(bool& running, bool& recordToggleRequested) {
     }
 }
 
-void CameraWindow::updateFrame(const std::vector<uint8_t> &rgb_data, const std::vector<uint16_t> &thermal_data, int w,
-                               int h) {
-    if (rotation == 0) {
-        if (w != 256 || h != 192) return;
-        SDL_UpdateTexture(texture, NULL, rgb_data.data(), w * 3);
-        currentThermal = thermal_data;
-    } else {
-        // Rotate
-        int origW = 256;
-        int origH = 192;
-        std::vector<uint8_t> rotRGB(origW * origH * 3);
-        std::vector<uint16_t> rotThermal(origW * origH);
-
-        for (int y = 0; y < origH; ++y) {
-            for (int x = 0; x < origW; ++x) {
-                int nx, ny;
-                if (rotation == 90) {
-                    // Anti-clockwise
-                    nx = y;
-                    ny = origW - 1 - x;
-                } else if (rotation == 180) {
-                    nx = origW - 1 - x;
-                    ny = origH - 1 - y;
-                } else if (rotation == 270) {
-                    nx = origH - 1 - y;
-                    ny = x;
-                } else {
-                    nx = x;
-                    ny = y;
-                }
+void CameraWindow::updateFrame(const FramePool::Handle &frame) {
+    if (!frame) return;
+    const std::vector<uint8_t> &camera_rgb = frame->rgb;
+    const std::vector<uint16_t> &thermal_data = frame->thermal;
+    const int w = SensorWidth;
+    const int h = SensorHeight;
+    if (camera_rgb.size() != (size_t) (w * h * 3) || thermal_data.size() != (size_t) (w * h)) return;
+
+    const std::vector<uint8_t> *rgb_source = &camera_rgb;
+    int64_t uploadStart = metrics ? PipelineMetrics::nowUs() : 0;
+    std::unique_lock<std::mutex> lock = lockAnalysis();
+    bool showHeatmap = heatmapMode > 0 && pixelStats && pixelStats->frameCount() > 0;
+    heatmapShown = showHeatmap;
+    if (showHeatmap) {
+        enhancedGray.resize(w * h);
+        enhancedRGB.resize(w * h * 3);
+        pixelStats->heatmap(heatmapModes[heatmapMode].statistic, enhancedGray.data());
+    }
+    if (lock) lock.unlock();
+
+    if (showHeatmap) {
+        Palette::colorize(enhancedGray.data(), enhancedRGB.data(), w * h, Palette::Type::Rainbow);
+        rgb_source = &enhancedRGB;
+    } else if (detailEnhancement) {
+        enhancedGray.resize(w * h);
+        enhancedRGB.resize(w * h * 3);
+        detailEnhancer.process(thermal_data.data(), enhancedGray.data(), &ThreadPool::shared());
+        Palette::colorize(enhancedGray.data(), enhancedRGB.data(), w * h, enhancementPalette);
+        rgb_source = &enhancedRGB;
+    }
 
-                int oldIdx = (y * origW + x);
-                int newIdx = (ny * baseWidth + nx);
+    // Uploaded in sensor orientation; render() rotates on the GPU. The frame is kept referenced
+    // for the pointer readout instead of copying its thermal plane
+    SDL_UpdateTexture(texture, NULL, rgb_source->data(), w * 3);
+    currentFrame = frame;
+    if (metrics) {
+        metrics->record(PipelineMetrics::Upload, PipelineMetrics::nowUs() - uploadStart);
+        metrics->frameDisplayed();
+    }
+    // Overlays and the pointer readout are recomputed with every frame
+    dirtyLayers |= LayerVideo | LayerOverlay | LayerTooltip;
+}
 
-                rotRGB[newIdx * 3] = rgb_data[oldIdx * 3];
-                rotRGB[newIdx * 3 + 1] = rgb_data[oldIdx * 3 + 1];
-                rotRGB[newIdx * 3 + 2] = rgb_data[oldIdx * 3 + 2];
-                rotThermal[newIdx] = thermal_data[oldIdx];
-            }
+bool CameraWindow::render(bool isRecording, bool indicatorVisible, bool isConnected, const HotSpotResult &hotSpot,
+                          const std::vector<Blob> &blobs) {
+    if (isRecording != lastRecording) dirtyLayers |= LayerToolbar | LayerOverlay;
+    if (indicatorVisible != lastIndicatorVisible) dirtyLayers |= LayerOverlay;
+    if (isConnected != lastConnected) dirtyLayers = LayerAll;
+    lastRecording = isRecording;
+    lastIndicatorVisible = indicatorVisible;
+    lastConnected = isConnected;
+
+    // The HUD refreshes its numbers twice a second; summarizing is the only cost of the metrics
+    if (showMetrics && metrics) {
+        int64_t now = PipelineMetrics::nowUs();
+        if (now - metricsRefreshUs >= 500000) {
+            metricsSummary = metrics->summarize();
+            metricsRefreshUs = now;
+            dirtyLayers |= LayerOverlay;
         }
-        SDL_UpdateTexture(texture, NULL, rotRGB.data(), baseWidth * 3);
-        currentThermal = rotThermal;
     }
-}
 
-void CameraWindow::render(bool isRecording, bool indicatorVisible, bool isConnected, const HotSpotResult &hotSpot) {
+    // Nothing changed since the last present: skip the frame, leaving CPU and GPU idle
+    if (!dirtyLayers) return false;
+
+    // For quarter turns the sensor-oriented rectangle is the viewport transposed around its
+    // centre; SDL angles are clockwise, our rotation anti-clockwise
+    bool quarter = rotation == 90 || rotation == 270;
+    int w = quarter ? currentHeight : currentWidth;
+    int h = quarter ? currentWidth : currentHeight;
+    SDL_Rect dest = {(currentWidth - w) / 2, toolbarHeight + (currentHeight - h) / 2, w, h};
+    double angle = (double) ((360 - rotation) % 360);
+
+    // Only the visible region is drawn. Interpolating upscalers resample it on the host when the
+    // view is magnified; everything else lets the GPU scale the full-frame texture
+    SDL_Rect src = visibleSensorRect();
+    bool hostUpscale = isConnected && upscaleMethod != ThermalUpscaler::Method::Nearest && currentFrame &&
+                       !detailEnhancement && !heatmapShown && w > src.w;
+    if (hostUpscale && (dirtyLayers & LayerVideo)) hostUpscale = upscaleVisibleRegion(src, w, h);
+    hostUpscale = hostUpscale && upscaledTexture;
+
+    // Composited into its own texture when it changed, so before anything is drawn to the window
+    bool legendShown = showLegend && isConnected && currentFrame && !heatmapShown && updateLegend(hostUpscale);
+
+    // The back buffer is undefined after a present, so a change in any layer redraws them all;
+    // with vsync the present below paces the redraws to the display
     SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
     SDL_RenderClear(renderer);
 
     renderToolbar(isRecording);
 
+    overlay.clear();
     if (isConnected) {
-        SDL_Rect viewport = {0, toolbarHeight, currentWidth, currentHeight};
-        SDL_RenderCopy(renderer, texture, NULL, &viewport);
+        if (hostUpscale) {
+            SDL_RenderCopyEx(renderer, upscaledTexture, NULL, &dest, angle, NULL, SDL_FLIP_NONE);
+        } else {
+            SDL_RenderCopyEx(renderer, texture, &src, &dest, angle, NULL, SDL_FLIP_NONE);
+        }
 
+        if (legendShown) {
+            SDL_Rect legendRect = {currentWidth - legendWidth - 6, toolbarHeight + (currentHeight - legendHeight) / 2,
+                                   legendWidth, legendHeight};
+            SDL_RenderCopy(renderer, legendTexture, NULL, &legendRect);
+        }
+
+        // Every annotation goes into one batch, drawn with a call per texture at the end. Building
+        // it reads the analyzers shared with the capture thread, submitting it does not
+        std::unique_lock<std::mutex> lock = lockAnalysis();
+        if (showBlobs) {
+            renderBlobs(blobs);
+        }
+        renderRois();
         renderHotSpot(hotSpot);
+        renderAlarms();
 
         if (showMouseTemp) {
             renderMouseTemp();
@@ -271,8 +524,31 @@ void CameraWindow::render(bool isRecording, bool indicatorVisible, bool isConnec
     } else {
         renderScanningMessage();
     }
-
-    SDL_RenderPresent(renderer);
+    if (showMetrics && metrics) {
+        renderMetrics();
+    }
+    // Annotations outside a zoomed view must not spill onto the toolbar
+    SDL_Rect viewArea = {0, toolbarHeight, currentWidth, currentHeight};
+    SDL_RenderSetClipRect(renderer, &viewArea);
+    overlay.submit(renderer);
+    SDL_RenderSetClipRect(renderer, NULL);
+
+    {
+        PipelineMetrics::Timer timer(metrics, PipelineMetrics::Present);
+        SDL_RenderPresent(renderer);
+    }
+    dirtyLayers = 0;
+
+    if (metrics) {
+        metrics->framePresented();
+        // Capture to present, once per frame: the first present that showed it
+        if (isConnected && currentFrame && currentFrame->captureTimeUs > 0 &&
+            currentFrame->captureTimeUs != lastPresentedCaptureUs) {
+            lastPresentedCaptureUs = currentFrame->captureTimeUs;
+            metrics->record(PipelineMetrics::Latency, PipelineMetrics::nowUs() - lastPresentedCaptureUs);
+        }
+    }
+    return true;
 }
 
 void CameraWindow::initIcons() {
@@ -392,20 +668,23 @@ void CameraWindow::renderToolbar(bool isRecording) {
     drawIcon(iconZoomOut, 175, false);
     drawIcon(iconZoomIn, 215, false);
     
-    // Render current scale text
-    if (font) {
-        char scaleText[16];
-        snprintf(scaleText, sizeof(scaleText), "%.0f%%", currentScale * 100.0f);
+    // Render current scale text; it only changes on zoom, so it comes from the text cache
+    if (text.ready()) {
+        char scaleText[48];
+        if (zoom > 1 || upscaleMethod != ThermalUpscaler::Method::Nearest) {
+            snprintf(scaleText, sizeof(scaleText), "%.0f%%  %dx %s", currentScale * 100.0f, zoom,
+                     ThermalUpscaler::methodName(upscaleMethod));
+        } else {
+            snprintf(scaleText, sizeof(scaleText), "%.0f%%", currentScale * 100.0f);
+        }
         SDL_Color white = {200, 200, 200, 255};
-        SDL_Surface* surface = TTF_RenderText_Blended(font, scaleText, white);
-        if (surface) {
-            SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, surface);
-            if (tex) {
-                SDL_Rect dest = { 245, toolbarHeight / 2 - surface->h / 2, surface->w, surface->h };
-                SDL_RenderCopy(renderer, tex, NULL, &dest);
-                SDL_DestroyTexture(tex);
-            }
-            SDL_FreeSurface(surface);
+        int textY = toolbarHeight / 2 - text.lineHeight() / 2;
+        int textX = 245 + text.drawCached(scaleText, 245, textY, white).x;
+
+        if (heatmapMode > 0 && pixelStats) {
+            char mapText[48];
+            snprintf(mapText, sizeof(mapText), "Map: %s", heatmapModes[heatmapMode].name);
+            text.drawCached(mapText, std::max(300, textX + 12), textY, white);
         }
     }
 }
@@ -413,104 +692,413 @@ void CameraWindow::renderToolbar(bool isRecording) {
 void CameraWindow::renderIndicator() {
     int padding = 20;
     int radius = 8;
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
     // Draw a simple red circle indicator
-    for (int w = -radius; w <= radius; w++) {
-        for (int h = -radius; h <= radius; h++) {
-            if (w * w + h * h <= radius * radius) {
-                SDL_RenderDrawPoint(renderer, padding + radius + w, toolbarHeight + padding + radius + h);
-            }
-        }
-    }
+    overlay.fillCircle(padding + radius + 0.5f, toolbarHeight + padding + radius + 0.5f, radius + 0.5f,
+                       SDL_Color{255, 0, 0, 255});
 }
 
 void CameraWindow::renderMouseTemp() {
-    if (currentThermal.empty() || !font) return;
+    if (!currentFrame || !text.ready() || !calibration) return;
 
     if (mouseY < toolbarHeight) return;
 
-    // Scale from logical size to base dimensions
-    float invScaleX = (float) baseWidth / (float) currentWidth;
-    float invScaleY = (float) baseHeight / (float) currentHeight;
-
-    int tx = (int) (mouseX * invScaleX);
-    int ty = (int) ((mouseY - toolbarHeight) * invScaleY);
+    // Logical position to the display pixel under the pointer
+    SDL_FPoint d = viewToDisplay((float) mouseX, (float) mouseY);
+    int tx = (int) std::floor(d.x);
+    int ty = (int) std::floor(d.y);
 
     if (tx < 0 || tx >= baseWidth || ty < 0 || ty >= baseHeight) return;
 
-    uint16_t val = currentThermal[ty * baseWidth + tx];
-    double tempC = (val / 64.0) - 273.15;
+    // The plane is kept in sensor orientation
+    SDL_FPoint sp = displayToSensor((float) tx, (float) ty);
+    uint16_t val = currentFrame->thermal[(int) sp.y * SensorWidth + (int) sp.x];
 
-    char text[32];
-    snprintf(text, sizeof(text), "%.1f C", tempC);
+    char label[32];
+    snprintf(label, sizeof(label), "%.1f %s", calibration->toTemperature(val), calibration->unitSuffix());
 
     SDL_Color white = {255, 255, 255, 255};
+    SDL_Point size = text.measure(label);
+    int tooltipX = mouseX + 15;
+    int tooltipY = mouseY - 25;
+
+    // Background rect
+    SDL_Rect bgRect = {tooltipX - 2, tooltipY - 2, size.x + 4, size.y + 4};
+    overlay.fillRect(bgRect, SDL_Color{0, 0, 0, 180});
+
+    text.draw(label, tooltipX, tooltipY, white, overlay);
+}
+
+void CameraWindow::renderMetrics() {
+    if (!text.ready()) return;
+    const PipelineMetrics::Summary &m = metricsSummary;
+    char lines[PipelineMetrics::StageCount + 2][64];
+    snprintf(lines[0], sizeof(lines[0]), "capture %.1f fps  render %.1f fps", m.captureFps, m.renderFps);
+    snprintf(lines[1], sizeof(lines[1]), "dropped %llu  not shown %llu", (unsigned long long) m.dropped,
+             (unsigned long long) m.notShown);
+    for (int s = 0; s < PipelineMetrics::StageCount; ++s) {
+        const PipelineMetrics::StageSummary &stage = m.stages[s];
+        if (stage.samples == 0) {
+            snprintf(lines[s + 2], sizeof(lines[s + 2]), "%-9s -", PipelineMetrics::stageName((PipelineMetrics::Stage) s));
+        } else {
+            snprintf(lines[s + 2], sizeof(lines[s + 2]), "%-9s p50 %.2f  p99 %.2f ms",
+                     PipelineMetrics::stageName((PipelineMetrics::Stage) s), stage.p50Ms, stage.p99Ms);
+        }
+    }
+
+    const int lineCount = PipelineMetrics::StageCount + 2;
+    int width = 0;
+    for (int i = 0; i < lineCount; ++i) width = std::max(width, text.measure(lines[i]).x);
+    int lineHeight = text.lineHeight();
+    SDL_Rect panel = {currentWidth - width - 12, toolbarHeight + 4, width + 8, lineHeight * lineCount + 6};
+    overlay.fillRect(panel, SDL_Color{0, 0, 0, 180});
+    SDL_Color color = {180, 255, 180, 255};
+    for (int i = 0; i < lineCount; ++i) {
+        text.draw(lines[i], panel.x + 4, panel.y + 3 + i * lineHeight, color, overlay);
+    }
+}
+
+bool CameraWindow::updateLegend(bool hostUpscale) {
+    if (!calibration || !text.ready()) return false;
 
-    SDL_Surface *surface = TTF_RenderText_Blended(font, text, white);
-    if (surface) {
-        SDL_Texture *msgTexture = SDL_CreateTextureFromSurface(renderer, surface);
-        if (msgTexture) {
-            int tooltipX = mouseX + 15;
-            int tooltipY = mouseY - 25;
-
-            // Background rect
-            SDL_Rect bgRect = {tooltipX - 2, tooltipY - 2, surface->w + 4, surface->h + 4};
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
-            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-            SDL_RenderFillRect(renderer, &bgRect);
-            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
-
-            SDL_Rect dstRect = {tooltipX, tooltipY, surface->w, surface->h};
-            SDL_RenderCopy(renderer, msgTexture, NULL, &dstRect);
-            SDL_DestroyTexture(msgTexture);
+    // The camera colorizes with its iron red palette and an AGC close to the frame's range
+    uint16_t low = agcLow, high = agcHigh;
+    if (!hostUpscale) {
+        if (dirtyLayers & LayerVideo) {
+            FrameStats stats = FrameStats::compute(currentFrame->thermal.data(), SensorWidth * SensorHeight);
+            frameLow = stats.min;
+            frameHigh = stats.max;
         }
-        SDL_FreeSurface(surface);
+        low = frameLow;
+        high = frameHigh;
     }
+    Palette::Type palette = hostUpscale || detailEnhancement ? enhancementPalette : Palette::Type::IronRed;
+
+    bool changed;
+    {
+        std::unique_lock<std::mutex> lock = lockAnalysis();
+        changed = legend.set(palette, calibration->toTemperature(low), calibration->toTemperature(high),
+                             calibration->unitSuffix());
+    }
+    // Half the window's height, so a resize, scale or rotation redraws it just like a new label
+    int lineHeight = text.lineHeight();
+    int height = std::max(lineHeight * 4, currentHeight / 2);
+    if (!changed && legendTexture && !legendStale && height == legendHeight) return true;
+
+    // Gradient strip, hottest at the top; only another palette changes it
+    if (!gradientTexture || gradientPalette != legend.palette()) {
+        if (!gradientTexture) {
+            gradientTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STATIC, 1, 256);
+            if (!gradientTexture) return false;
+        }
+        uint8_t strip[256 * 3];
+        const uint8_t *lut = Palette::table(legend.palette());
+        for (int i = 0; i < 256; ++i) std::memcpy(strip + i * 3, lut + (255 - i) * 3, 3);
+        SDL_UpdateTexture(gradientTexture, NULL, strip, 3);
+        gradientPalette = legend.palette();
+    }
+
+    SDL_Point highSize = text.measure(legend.highLabel().c_str());
+    SDL_Point lowSize = text.measure(legend.lowLabel().c_str());
+    int width = std::max(highSize.x, lowSize.x) + 8;
+    if (!legendTexture || width != legendWidth || height != legendHeight) {
+        if (legendTexture) SDL_DestroyTexture(legendTexture);
+        legendTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!legendTexture) {
+            dprintf("CameraWindow - Could not create the legend texture: %s\n", SDL_GetError());
+            return false;
+        }
+        SDL_SetTextureBlendMode(legendTexture, SDL_BLENDMODE_BLEND);
+        legendWidth = width;
+        legendHeight = height;
+    }
+
+    // Panel, gradient and labels from the glyph atlas, composited once into the legend texture
+    SDL_SetRenderTarget(renderer, legendTexture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderClear(renderer);
+    SDL_Rect bar = {(width - 12) / 2, lineHeight + 4, 12, height - 2 * lineHeight - 8};
+    SDL_RenderCopy(renderer, gradientTexture, NULL, &bar);
+    SDL_Color white = {255, 255, 255, 255};
+    text.draw(legend.highLabel().c_str(), (width - highSize.x) / 2, 2, white);
+    text.draw(legend.lowLabel().c_str(), (width - lowSize.x) / 2, height - lineHeight - 2, white);
+    SDL_SetRenderTarget(renderer, NULL);
+    legendStale = false;
+    return true;
 }
 
 void CameraWindow::renderScanningMessage() {
-    if (!font) return;
-    std::string msg = "Searching for P2Pro camera...";
+    if (!text.ready()) return;
+    const char *msg = "Searching for P2Pro camera...";
     SDL_Color white = {255, 255, 255, 255};
-    SDL_Surface* surface = TTF_RenderText_Blended(font, msg.c_str(), white);
-    if (surface) {
-        SDL_Texture* msgTexture = SDL_CreateTextureFromSurface(renderer, surface);
-        if (msgTexture) {
-            SDL_Rect dstRect = { (currentWidth - surface->w) / 2, (currentHeight - surface->h) / 2 + toolbarHeight, surface->w, surface->h };
-            SDL_RenderCopy(renderer, msgTexture, NULL, &dstRect);
-            SDL_DestroyTexture(msgTexture);
+    SDL_Point size = text.measure(msg);
+    text.drawCached(msg, (currentWidth - size.x) / 2, (currentHeight - size.y) / 2 + toolbarHeight, white);
+}
+
+SDL_FPoint CameraWindow::sensorToDisplay(float sx, float sy) const {
+    switch (rotation) {
+        case 90: return {sy, SensorWidth - 1 - sx};
+        case 180: return {SensorWidth - 1 - sx, SensorHeight - 1 - sy};
+        case 270: return {SensorHeight - 1 - sy, sx};
+        default: return {sx, sy};
+    }
+}
+
+SDL_FPoint CameraWindow::displayToSensor(float dx, float dy) const {
+    switch (rotation) {
+        case 90: return {SensorWidth - 1 - dy, dx};
+        case 180: return {SensorWidth - 1 - dx, SensorHeight - 1 - dy};
+        case 270: return {dy, SensorHeight - 1 - dx};
+        default: return {dx, dy};
+    }
+}
+
+SDL_Point CameraWindow::sensorToView(float sx, float sy) const {
+    // Sensor coordinates are relative to the original sensor (256x192) and need rotating
+    SDL_FPoint r = sensorToDisplay(sx, sy);
+    SDL_FPoint v = displayToView(r.x, r.y);
+    return SDL_Point{(int) std::floor(v.x), (int) std::floor(v.y)};
+}
+
+SDL_FPoint CameraWindow::displayToView(float dx, float dy) const {
+    return {(dx - viewX) * (float) currentWidth / (float) viewWidth(),
+            (dy - viewY) * (float) currentHeight / (float) viewHeight() + toolbarHeight};
+}
+
+SDL_FPoint CameraWindow::viewToDisplay(float vx, float vy) const {
+    return {vx * (float) viewWidth() / (float) currentWidth + viewX,
+            (vy - toolbarHeight) * (float) viewHeight() / (float) currentHeight + viewY};
+}
+
+SDL_Rect CameraWindow::visibleSensorRect() const {
+    // Opposite corner pixels of the viewport; rotation may swap which one is top left
+    SDL_FPoint a = displayToSensor((float) viewX, (float) viewY);
+    SDL_FPoint b = displayToSensor((float) (viewX + viewWidth() - 1), (float) (viewY + viewHeight() - 1));
+    int x0 = (int) std::min(a.x, b.x), y0 = (int) std::min(a.y, b.y);
+    int x1 = (int) std::max(a.x, b.x), y1 = (int) std::max(a.y, b.y);
+    return SDL_Rect{x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+}
+
+bool CameraWindow::upscaleVisibleRegion(const SDL_Rect &src, int outW, int outH) {
+    PipelineMetrics::Timer timer(metrics, PipelineMetrics::Upscale);
+
+    // Beyond about a megapixel the GPU stretches the rest; detail below a sensor pixel is
+    // interpolated either way
+    const int maxPixels = 1280 * 960;
+    if (outW * outH > maxPixels) {
+        float shrink = std::sqrt((float) maxPixels / (float) (outW * outH));
+        outW = std::max(src.w, (int) (outW * shrink));
+        outH = std::max(src.h, (int) (outH * shrink));
+    }
+
+    if (!upscaledTexture || outW != upscaledWidth || outH != upscaledHeight) {
+        if (upscaledTexture) SDL_DestroyTexture(upscaledTexture);
+        upscaledTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING, outW, outH);
+        if (!upscaledTexture) {
+            dprintf("CameraWindow - Could not create the upscaled texture: %s\n", SDL_GetError());
+            upscaledWidth = upscaledHeight = 0;
+            return false;
+        }
+        upscaledWidth = outW;
+        upscaledHeight = outH;
+        upscaledThermal.resize(outW * outH);
+        upscaledRGB.resize(outW * outH * 3);
+    }
+
+    // AGC over the visible source pixels, so zooming into a detail also stretches its contrast
+    const uint16_t *plane = currentFrame->thermal.data();
+    uint16_t low = 65535, high = 0;
+    for (int y = src.y; y < src.y + src.h; ++y) {
+        const uint16_t *row = plane + y * SensorWidth;
+        for (int x = src.x; x < src.x + src.w; ++x) {
+            low = std::min(low, row[x]);
+            high = std::max(high, row[x]);
         }
-        SDL_FreeSurface(surface);
     }
+    agcLow = low;
+    agcHigh = high;
+
+    ThreadPool &pool = ThreadPool::shared();
+    upscaler.process(plane, src.x, src.y, src.w, src.h, upscaledThermal.data(), outW, outH, upscaleMethod, &pool);
+
+    // Map onto the palette band by band; the gray levels are written into the front of each
+    // band's RGB rows and expanded in place from the back
+    const float gain = 255.0f / (float) std::max(1, high - low);
+    const uint8_t *lut = Palette::table(enhancementPalette);
+    forEachBand(&pool, outH, [&](int y0, int y1) {
+        const uint16_t *v = upscaledThermal.data() + (size_t) y0 * outW;
+        uint8_t *rgb = upscaledRGB.data() + (size_t) y0 * outW * 3;
+        int count = (y1 - y0) * outW;
+        for (int i = 0; i < count; ++i) {
+            float level = std::min(std::max(((float) v[i] - low) * gain, 0.0f), 255.0f);
+            const uint8_t *c = lut + (int) level * 3;
+            rgb[i * 3] = c[0];
+            rgb[i * 3 + 1] = c[1];
+            rgb[i * 3 + 2] = c[2];
+        }
+    }, 32);
+
+    SDL_UpdateTexture(upscaledTexture, NULL, upscaledRGB.data(), outW * 3);
+    return true;
 }
 
-void CameraWindow::renderHotSpot(const HotSpotResult& hotSpot) {
-    if (!hotSpot.found) return;
+bool CameraWindow::takeBadPixelScanRequest() {
+    return badPixelScanRequested.exchange(false);
+}
+
+bool CameraWindow::takeFlatFieldRequest() {
+    return flatFieldRequested.exchange(false);
+}
 
-    // The hotSpot.x/y are relative to the original sensor (256x192)
-    // We need to rotate them if rotation is active
-    int rx = hotSpot.x;
-    int ry = hotSpot.y;
-    int origW = 256;
-    int origH = 192;
+std::unique_lock<std::mutex> CameraWindow::lockAnalysis() const {
+    return analysisMutex ? std::unique_lock<std::mutex>(*analysisMutex) : std::unique_lock<std::mutex>();
+}
+
+SDL_Point CameraWindow::roiToView(RoiPoint p) const {
+    // Continuous mapping with pixel centres at integer sensor coordinates
+    SDL_FPoint r = sensorToDisplay(p.x, p.y);
+    SDL_FPoint v = displayToView(r.x + 0.5f, r.y + 0.5f);
+    return SDL_Point{(int) std::lround(v.x), (int) std::lround(v.y)};
+}
+
+RoiPoint CameraWindow::viewToRoi(int vx, int vy) const {
+    SDL_FPoint d = viewToDisplay((float) vx, (float) vy);
+    SDL_FPoint sp = displayToSensor(d.x - 0.5f, d.y - 0.5f);
+    return {sp.x, sp.y};
+}
+
+void CameraWindow::outlineRoi(Roi::Shape shape, const std::vector<RoiPoint> &points, std::vector<SDL_Point> &out) const {
+    out.clear();
+    if (points.empty()) return;
 
-    if (rotation == 90) {
-        rx = hotSpot.y;
-        ry = origW - 1 - hotSpot.x;
-    } else if (rotation == 180) {
-        rx = origW - 1 - hotSpot.x;
-        ry = origH - 1 - hotSpot.y;
-    } else if (rotation == 270) {
-        rx = origH - 1 - hotSpot.y;
-        ry = hotSpot.x;
+    if (shape == Roi::Shape::Polygon) {
+        for (const RoiPoint &p: points) out.push_back(roiToView(p));
+        if (points.size() >= 3) out.push_back(out.front());
+        return;
     }
 
-    // Scale from base dimensions (rotated) to current logical size
-    float scaleX = (float) currentWidth / (float) baseWidth;
-    float scaleY = (float) currentHeight / (float) baseHeight;
+    // Outline the covered pixels, half a pixel outside their centres
+    float x0 = std::round(std::min(points[0].x, points[1].x)) - 0.5f, x1 = std::round(std::max(points[0].x, points[1].x)) + 0.5f;
+    float y0 = std::round(std::min(points[0].y, points[1].y)) - 0.5f, y1 = std::round(std::max(points[0].y, points[1].y)) + 0.5f;
+    if (shape == Roi::Shape::Rectangle) {
+        RoiPoint corners[5] = {{x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}, {x0, y0}};
+        for (const RoiPoint &c: corners) out.push_back(roiToView(c));
+    } else {
+        float cx = (points[0].x + points[1].x) * 0.5f, cy = (points[0].y + points[1].y) * 0.5f;
+        float rx = std::fabs(points[1].x - points[0].x) * 0.5f + 0.5f, ry = std::fabs(points[1].y - points[0].y) * 0.5f + 0.5f;
+        const int segments = 48;
+        for (int i = 0; i <= segments; ++i) {
+            float a = 2.0f * (float) M_PI * i / segments;
+            out.push_back(roiToView({cx + rx * std::cos(a), cy + ry * std::sin(a)}));
+        }
+    }
+}
 
-    int x = (int) (rx * scaleX);
-    int y = (int) (ry * scaleY) + toolbarHeight;
+void CameraWindow::renderRois() {
+    if (!roiAnalyzer) return;
+
+    std::vector<SDL_Point> &outline = outlineScratch;
+    const SDL_Color white = {255, 255, 255, 255};
+    const auto &rois = roiAnalyzer->rois();
+    const auto &results = roiAnalyzer->results();
+    for (size_t i = 0; i < rois.size(); ++i) {
+        outlineRoi(rois[i].shape, rois[i].points, outline);
+        overlay.drawLines(outline.data(), (int) outline.size(), white);
+
+        if (!text.ready() || !calibration || results[i].count == 0) continue;
+        SDL_Point anchor = outline.front();
+        for (const SDL_Point &p: outline) {
+            if (p.y < anchor.y) anchor = p;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "R%d %.1f (%.1f..%.1f)", rois[i].id,
+                 calibration->toTemperatureInterpolated((float) results[i].mean),
+                 calibration->toTemperature(results[i].min), calibration->toTemperature(results[i].max));
+
+        SDL_Point size = text.measure(label);
+        SDL_Rect dstRect = {anchor.x, anchor.y - size.y - 2, size.x, size.y};
+        if (dstRect.y < toolbarHeight) dstRect.y = anchor.y + 2;
+        SDL_Rect bgRect = {dstRect.x - 2, dstRect.y - 1, dstRect.w + 4, dstRect.h + 2};
+        overlay.fillRect(bgRect, SDL_Color{0, 0, 0, 160});
+        text.draw(label, dstRect.x, dstRect.y, white, overlay);
+    }
+
+    // Regions being drawn
+    const SDL_Color yellow = {255, 255, 0, 255};
+    if (roiDragging) {
+        bool ellipse = (SDL_GetModState() & KMOD_SHIFT) != 0;
+        outlineRoi(ellipse ? Roi::Shape::Ellipse : Roi::Shape::Rectangle, {roiDragStart, roiDragEnd}, outline);
+        overlay.drawLines(outline.data(), (int) outline.size(), yellow);
+    }
+    if (!polygonDraft.empty()) {
+        // Open polyline from the placed vertices to the cursor
+        outline.clear();
+        for (const RoiPoint &p: polygonDraft) outline.push_back(roiToView(p));
+        outline.push_back(SDL_Point{mouseX, mouseY});
+        overlay.drawLines(outline.data(), (int) outline.size(), yellow);
+    }
+}
+
+void CameraWindow::renderAlarms() {
+    if (!alarmEngine || !text.ready()) return;
+    const std::vector<AlarmEngine::Rule> &rules = alarmEngine->rules();
+    const std::vector<AlarmEngine::RuleState> &states = alarmEngine->states();
+
+    std::string banner;
+    for (size_t i = 0; i < states.size() && i < rules.size(); ++i) {
+        if (!states[i].active) continue;
+        char item[64];
+        snprintf(item, sizeof(item), "%s%s %.1f", banner.empty() ? "ALARM: " : ", ", rules[i].name.c_str(),
+                 states[i].value);
+        banner += item;
+    }
+    if (banner.empty()) return;
+
+    SDL_Color white = {255, 255, 255, 255};
+    int h = text.lineHeight();
+    SDL_Rect band = {0, toolbarHeight + currentHeight - h - 8, currentWidth, h + 8};
+    overlay.fillRect(band, SDL_Color{200, 0, 0, 180});
+    text.draw(banner.c_str(), 6, band.y + 4, white, overlay);
+}
+
+void CameraWindow::renderBlobs(const std::vector<Blob> &blobs) {
+    for (const Blob &b: blobs) {
+        // Transform opposite corner pixels of the box; rotation may swap which one is top left
+        SDL_Point a = sensorToView(b.minX, b.minY);
+        SDL_Point c = sensorToView(b.maxX, b.maxY);
+        int cellW = std::max(1, currentWidth / viewWidth());
+        int cellH = std::max(1, currentHeight / viewHeight());
+        SDL_Rect box = {std::min(a.x, c.x), std::min(a.y, c.y), std::abs(c.x - a.x) + cellW, std::abs(c.y - a.y) + cellH};
+
+        overlay.drawRect(box, b.cold ? SDL_Color{64, 160, 255, 255} : SDL_Color{255, 64, 64, 255});
+
+        if (!text.ready() || !calibration) continue;
+        char label[32];
+        if (b.trackId >= 0) {
+            snprintf(label, sizeof(label), "#%d %.1f", b.trackId, calibration->toTemperature(b.peak));
+        } else {
+            snprintf(label, sizeof(label), "%.1f", calibration->toTemperature(b.peak));
+        }
+
+        SDL_Color white = {255, 255, 255, 255};
+        SDL_Point size = text.measure(label);
+        SDL_Rect dstRect = {box.x, box.y - size.y - 2, size.x, size.y};
+        if (dstRect.y < toolbarHeight) dstRect.y = box.y + box.h + 2;
+
+        SDL_Rect bgRect = {dstRect.x - 2, dstRect.y - 1, dstRect.w + 4, dstRect.h + 2};
+        overlay.fillRect(bgRect, SDL_Color{0, 0, 0, 160});
+
+        text.draw(label, dstRect.x, dstRect.y, white, overlay);
+    }
+}
+
+void CameraWindow::renderHotSpot(const HotSpotResult& hotSpot) {
+    if (!hotSpot.found) return;
+
+    // Sub-pixel position keeps the crosshair smooth at high zoom
+    SDL_Point p = sensorToView(hotSpot.fx, hotSpot.fy);
+    int x = p.x;
+    int y = p.y;
 
     // Safety check to avoid rendering outside the window/toolbar
     if (x < 0 || x >= currentWidth || y < toolbarHeight || y >= currentHeight + toolbarHeight) return;
@@ -521,15 +1109,20 @@ void CameraWindow::renderHotSpot(const HotSpotResult& hotSpot) {
     uint8_t invB = 255 - hotSpot.b;
     
     // Draw Crosshair (Inverse Color)
-    SDL_SetRenderDrawColor(renderer, invR, invG, invB, 255);
-    int crossSize = 12;
-    SDL_RenderDrawLine(renderer, x - crossSize, y, x + crossSize, y);
-    SDL_RenderDrawLine(renderer, x, y - crossSize, x, y + crossSize);
-
-    // Render Text using SDL_ttf
-    if (!font) return;
-    char text[32];
-    snprintf(text, sizeof(text), "%.1f C", hotSpot.tempC);
+    SDL_Color crossColor = {invR, invG, invB, 255};
+    float crossSize = 12.0f;
+    overlay.drawLine(x - crossSize, (float) y, x + crossSize, (float) y, crossColor);
+    overlay.drawLine((float) x, y - crossSize, (float) x, y + crossSize, crossColor);
+
+    // Render text from the glyph atlas
+    if (!text.ready()) return;
+    char label[32];
+    if (calibration) {
+        // Looked up from the raw value so a unit change applies immediately
+        snprintf(label, sizeof(label), "%.1f %s", calibration->toTemperatureInterpolated(hotSpot.peak), calibration->unitSuffix());
+    } else {
+        snprintf(label, sizeof(label), "%.1f", hotSpot.temperature);
+    }
 
     // Contrast outline (hysteresis to prevent flickering)
     int brightness = hotSpot.r + hotSpot.g + hotSpot.b;
@@ -542,31 +1135,12 @@ void CameraWindow::renderHotSpot(const HotSpotResult& hotSpot) {
     SDL_Color outlineColor = darkOutline ? SDL_Color{0, 0, 0, 255} : SDL_Color{255, 255, 255, 255};
     SDL_Color textColor = {invR, invG, invB, 255};
 
-    // Render shadow/outline first
-    SDL_Surface* shadowSurface = TTF_RenderText_Blended(font, text, outlineColor);
-    if (shadowSurface) {
-        SDL_Texture* shadowTexture = SDL_CreateTextureFromSurface(renderer, shadowSurface);
-        if (shadowTexture) {
-            SDL_Rect destRect = { x + 8 + 1, y - 8 - shadowSurface->h + 1, shadowSurface->w, shadowSurface->h };
-            if (destRect.x + destRect.w > currentWidth) destRect.x = x - 8 - destRect.w + 1;
-            if (destRect.y < toolbarHeight) destRect.y = y + 8 + 1;
-            SDL_RenderCopy(renderer, shadowTexture, NULL, &destRect);
-            SDL_DestroyTexture(shadowTexture);
-        }
+    SDL_Point size = text.measure(label);
+    SDL_Rect destRect = { x + 8, y - 8 - size.y, size.x, size.y };
+    if (destRect.x + destRect.w > currentWidth) destRect.x = x - 8 - destRect.w;
+    if (destRect.y < toolbarHeight) destRect.y = y + 8;
 
-        // Render main text
-        SDL_Surface* textSurface = TTF_RenderText_Blended(font, text, textColor);
-        if (textSurface) {
-            SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-            if (textTexture) {
-                SDL_Rect destRect = { x + 8, y - 8 - textSurface->h, textSurface->w, textSurface->h };
-                if (destRect.x + destRect.w > currentWidth) destRect.x = x - 8 - destRect.w;
-                if (destRect.y < toolbarHeight) destRect.y = y + 8;
-                SDL_RenderCopy(renderer, textTexture, NULL, &destRect);
-                SDL_DestroyTexture(textTexture);
-            }
-            SDL_FreeSurface(textSurface);
-        }
-        SDL_FreeSurface(shadowSurface);
-    }
+    // Render shadow/outline first, then the main text
+    text.draw(label, destRect.x + 1, destRect.y + 1, outlineColor, overlay);
+    text.draw(label, destRect.x, destRect.y, textColor, overlay);
 }
@@ -3,10 +3,25 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "P2Pro.hpp"
+#include "FramePool.hpp"
 #include "Scaler.hpp"
+#include "DetailEnhancer.hpp"
+#include "Palette.hpp"
+#include "ThermalCalibration.hpp"
+#include "BlobDetector.hpp"
+#include "RoiAnalyzer.hpp"
+#include "PixelStatsAccumulator.hpp"
+#include "AlarmEngine.hpp"
+#include "TextRenderer.hpp"
+#include "OverlayBatch.hpp"
+#include "PipelineMetrics.hpp"
+#include "ThermalUpscaler.hpp"
+#include "ColorbarLegend.hpp"
 
 class CameraWindow {
 public:
@@ -18,15 +33,80 @@ public:
 
     void pollEvents(bool &running, bool &recordToggleRequested);
 
-    void updateFrame(const std::vector<uint8_t> &rgb_data, const std::vector<uint16_t> &thermal_data, int w, int h);
+    // Shows the frame and keeps a reference to it until the next one arrives
+    void updateFrame(const FramePool::Handle &frame);
 
-    void render(bool isRecording, bool indicatorVisible, bool isConnected, const HotSpotResult &hotSpot = {});
+    // Draws and presents only when a layer changed since the last present (a new frame, input,
+    // or a change in the arguments); returns whether it presented
+    bool render(bool isRecording, bool indicatorVisible, bool isConnected, const HotSpotResult &hotSpot = {},
+                const std::vector<Blob> &blobs = {});
+
+    // Forces the next render() to redraw, for state changed outside the window
+    void invalidate();
+
+    // Sleeps until an input event is pending, wake() was called or the timeout expires
+    void waitForEvents(int timeoutMs);
+
+    // Ends a waitForEvents() early, e.g. when a new frame is ready; callable from any thread
+    void wake();
+
+    // Frame rates and stage timings; 'h' shows them in a HUD. The window records the upload,
+    // present and capture-to-present latency stages itself
+    void setPipelineMetrics(PipelineMetrics *m) { metrics = m; }
+
+    // Mutex held while the window reads or edits the calibration, regions, statistics or alarm
+    // states below, for when another thread updates them; never held across a present
+    void setAnalysisMutex(std::mutex *mutex) { analysisMutex = mutex; }
 
     void setRotation(int degrees); // 0, 90, 180, 270
     void setScale(float scale);
     float getScale() const;
 
+    // Viewport into the image: the mouse wheel zooms in powers of two around the pointer up to
+    // 16x, dragging with the middle button or the arrow keys pan, '0' shows the whole image again
+    void setZoom(int level);
+    int getZoom() const { return zoom; }
+
+    // Interpolation of the visible Y16 region, cycled with 'i'. Nearest keeps the camera's own
+    // colorization scaled on the GPU; the others resample the raw values of only the visible
+    // region and colorize them on the host with a linear AGC over that region
+    void setUpscaleMethod(ThermalUpscaler::Method method);
+    ThermalUpscaler::Method getUpscaleMethod() const { return upscaleMethod; }
+
+    // Temperature legend along the right edge, toggled with 'l'. It is composited into a texture
+    // that is only redrawn when the palette or a range label changes
+    void setLegendVisible(bool visible) { showLegend = visible; dirtyLayers = LayerAll; }
+    bool getLegendVisible() const { return showLegend; }
+
+    // Per-view detail enhancement of the Y16 plane, colorized on the host instead of by the camera
+    void setDetailEnhancement(bool enabled);
+    bool getDetailEnhancement() const { return detailEnhancement; }
+
+    // Raw to temperature conversion used for readouts; the 'u' key cycles its display unit
+    void setCalibration(ThermalCalibration *cal) { calibration = cal; }
+
+    // Measurement regions: right-drag adds a rectangle (with Shift an ellipse), Ctrl+right-click
+    // adds polygon vertices and releasing Ctrl closes it, Backspace removes all regions
+    void setRoiAnalyzer(RoiAnalyzer *analyzer) { roiAnalyzer = analyzer; }
+
+    // Long-term statistics shown as a heatmap instead of the live image; 'm' cycles through
+    // max, standard deviation, range, time of max, mean and off
+    void setPixelStats(const PixelStatsAccumulator *stats) { pixelStats = stats; }
+
+    // Active alarms are listed in a banner along the bottom of the view
+    void setAlarmEngine(const AlarmEngine *engine) { alarmEngine = engine; }
+
+    // True once after 'p' was pressed to rescan the sensor's bad pixels; callable from any thread
+    bool takeBadPixelScanRequest();
+
+    // True once after 'f' was pressed to capture a flat field; a second capture at another scene
+    // temperature also calibrates the per-pixel gains
+    bool takeFlatFieldRequest();
+
 private:
+    static const int SensorWidth = 256;
+    static const int SensorHeight = 192;
+
     std::string title;
     int baseWidth;
     int baseHeight;
@@ -35,19 +115,92 @@ private:
     int toolbarHeight = 40;
     int rotation = 0; // 0, 90, 180, 270 degrees anti-clockwise
     float currentScale = 2.0f;
+    static const int MaxZoom = 16;
+    int zoom = 1;  // power of two, the visible region is baseWidth / zoom display pixels wide
+    int viewX = 0; // top-left visible display pixel, whole pixels so the GPU path can crop exactly
+    int viewY = 0;
+    bool panning = false;
+    int panStartX = 0;
+    int panStartY = 0;
+    int panViewX = 0;
+    int panViewY = 0;
     int mouseX = 0;
     int mouseY = 0;
     bool mouseOverRecordButton = false;
     bool showMouseTemp = false;
-    std::vector<uint16_t> currentThermal;
+    bool showBlobs = true; // toggled with 'b'
+    std::atomic<bool> badPixelScanRequested{false};
+    std::atomic<bool> flatFieldRequested{false};
+    FramePool::Handle currentFrame;
     bool darkOutline = true;
     bool isScanning = false;
     Scaler scaler;
+    ThermalCalibration *calibration = nullptr;
+    RoiAnalyzer *roiAnalyzer = nullptr;
+    const PixelStatsAccumulator *pixelStats = nullptr;
+    const AlarmEngine *alarmEngine = nullptr;
+    std::mutex *analysisMutex = nullptr;
+    PipelineMetrics *metrics = nullptr;
+    bool showMetrics = false;
+    PipelineMetrics::Summary metricsSummary;
+    int64_t metricsRefreshUs = 0;
+    int64_t lastPresentedCaptureUs = 0;
+    Uint32 wakeEvent = (Uint32) -1;
+    int heatmapMode = 0; // 0 = off, otherwise index into heatmapModes
+    bool heatmapShown = false; // the texture currently holds a heatmap
+    bool roiDragging = false;
+    RoiPoint roiDragStart = {0, 0};
+    RoiPoint roiDragEnd = {0, 0};
+    std::vector<RoiPoint> polygonDraft;
+
+    // Layers changed since the last present
+    enum Layer : uint32_t {
+        LayerVideo = 1 << 0,
+        LayerOverlay = 1 << 1,
+        LayerToolbar = 1 << 2,
+        LayerTooltip = 1 << 3,
+        LayerAll = LayerVideo | LayerOverlay | LayerToolbar | LayerTooltip
+    };
+    uint32_t dirtyLayers = LayerAll;
+    bool lastRecording = false;
+    bool lastIndicatorVisible = false;
+    bool lastConnected = false;
+
+    bool detailEnhancement = false;
+    Palette::Type enhancementPalette = Palette::Type::IronRed;
+    DetailEnhancer detailEnhancer;
+    std::vector<uint8_t> enhancedGray;
+    std::vector<uint8_t> enhancedRGB;
+
+    // Host-colorized visible region, recomputed whenever the video layer is redrawn
+    ThermalUpscaler::Method upscaleMethod = ThermalUpscaler::Method::Nearest;
+    ThermalUpscaler upscaler;
+    std::vector<uint16_t> upscaledThermal;
+    std::vector<uint8_t> upscaledRGB;
+    SDL_Texture *upscaledTexture = nullptr;
+    int upscaledWidth = 0;
+    int upscaledHeight = 0;
+    uint16_t agcLow = 0;  // raw range mapped onto the palette by the last upscale
+    uint16_t agcHigh = 0;
+
+    bool showLegend = false;
+    ColorbarLegend legend;
+    SDL_Texture *legendTexture = nullptr;   // render target, valid until the palette or a label changes
+    SDL_Texture *gradientTexture = nullptr; // 1x256 palette strip
+    Palette::Type gradientPalette = Palette::Type::IronRed;
+    bool legendStale = true;
+    int legendWidth = 0;
+    int legendHeight = 0;
+    uint16_t frameLow = 0;  // raw range of the shown frame, for the legend
+    uint16_t frameHigh = 0;
 
     SDL_Window *window = nullptr;
     SDL_Renderer *renderer = nullptr;
     SDL_Texture *texture = nullptr;
     TTF_Font *font = nullptr;
+    TextRenderer text;
+    OverlayBatch overlay;
+    std::vector<SDL_Point> outlineScratch;
     SDL_Cursor *crosshairCursor = nullptr;
     SDL_Cursor *defaultCursor = nullptr;
 
@@ -64,12 +217,35 @@ private:
     IconTexture iconZoomIn;
     IconTexture iconZoomOut;
 
+    std::unique_lock<std::mutex> lockAnalysis() const;
     bool isPointInCircle(int px, int py, int cx, int cy, int radius);
     void renderIndicator();
+    // Sensor pixel coordinates to the rotated display orientation (both unscaled) and back;
+    // every overlay and pointer mapping goes through these since frames are never rotated
+    SDL_FPoint sensorToDisplay(float sx, float sy) const;
+    SDL_FPoint displayToSensor(float dx, float dy) const;
+    SDL_Point sensorToView(float sx, float sy) const;
+    // Display pixel coordinates (pixel edges at integers) to the window and back, through the viewport
+    SDL_FPoint displayToView(float dx, float dy) const;
+    SDL_FPoint viewToDisplay(float vx, float vy) const;
+    int viewWidth() const { return baseWidth / zoom; }
+    int viewHeight() const { return baseHeight / zoom; }
+    void zoomAt(int level, int vx, int vy);
+    void clampViewport();
+    SDL_Rect visibleSensorRect() const;
+    bool upscaleVisibleRegion(const SDL_Rect &src, int outW, int outH);
     void renderHotSpot(const HotSpotResult &hotSpot);
+    void renderBlobs(const std::vector<Blob> &blobs);
+    SDL_Point roiToView(RoiPoint p) const;
+    RoiPoint viewToRoi(int vx, int vy) const;
+    void outlineRoi(Roi::Shape shape, const std::vector<RoiPoint> &points, std::vector<SDL_Point> &out) const;
+    void renderRois();
+    void renderAlarms();
     void renderMouseTemp();
     void renderToolbar(bool isRecording);
     void renderScanningMessage();
+    void renderMetrics();
+    bool updateLegend(bool hostUpscale);
     
     void cleanupIcons();
     void initIcons();
@@ -1,4 +1,5 @@
 #include "ColorConversion.hpp"
+#include "PixelFormat.hpp"
 #include <algorithm>
 
 namespace ColorConversion {
@@ -9,35 +10,48 @@ static inline uint8_t clamp(int v) {
     return (uint8_t)v;
 }
 
-void YUY2toRGB(const uint8_t* yuy2, uint8_t* rgb, int width, int height) {
-    int total_pixels = width * height;
-    for (int i = 0, j = 0; i < total_pixels * 2; i += 4, j += 6) {
-        int y0 = yuy2[i];
-        int u  = yuy2[i + 1] - 128;
-        int y1 = yuy2[i + 2];
-        int v  = yuy2[i + 3] - 128;
-
-        // Using BT.601 full range coefficients
-        int r_off = (359 * v) >> 8;
-        int g_off = (88 * u + 183 * v) >> 8;
-        int b_off = (454 * u) >> 8;
-
-        rgb[j]     = clamp(y0 + r_off);
-        rgb[j + 1] = clamp(y0 - g_off);
-        rgb[j + 2] = clamp(y0 + b_off);
-
-        rgb[j + 3] = clamp(y1 + r_off);
-        rgb[j + 4] = clamp(y1 - g_off);
-        rgb[j + 5] = clamp(y1 + b_off);
-    }
+void YUY2toRGB(const uint8_t* yuy2, uint8_t* rgb, int width, int height, ThreadPool* pool) {
+    PixelFormat::convert(PixelFormat::wrap(PixelFormat::Format::YUY2, width, height, yuy2),
+                         PixelFormat::wrap(PixelFormat::Format::RGB24, width, height, rgb), pool);
+}
+
+void RGBtoBGR(const uint8_t* rgb, uint8_t* bgr, int width, int height, ThreadPool* pool) {
+    PixelFormat::convert(PixelFormat::wrap(PixelFormat::Format::RGB24, width, height, rgb),
+                         PixelFormat::wrap(PixelFormat::Format::BGR24, width, height, bgr), pool);
+}
+
+void YUY2toYUV420P(const uint8_t* yuy2, const PlanarYUV420& dst, ThreadPool* pool) {
+    PixelFormat::Image out;
+    out.format = PixelFormat::Format::I420;
+    out.width = dst.width;
+    out.height = dst.height;
+    out.planes[0] = dst.y;
+    out.planes[1] = dst.u;
+    out.planes[2] = dst.v;
+    out.strides[0] = dst.strideY;
+    out.strides[1] = dst.strideU;
+    out.strides[2] = dst.strideV;
+    PixelFormat::convert(PixelFormat::wrap(PixelFormat::Format::YUY2, dst.width, dst.height, yuy2), out, pool);
 }
 
-void RGBtoBGR(const uint8_t* rgb, uint8_t* bgr, int width, int height) {
-    int total_bytes = width * height * 3;
-    for (int i = 0; i < total_bytes; i += 3) {
-        bgr[i]     = rgb[i + 2];
-        bgr[i + 1] = rgb[i + 1];
-        bgr[i + 2] = rgb[i];
+void YUV420PtoBGRA(const PlanarYUV420& src, uint8_t* bgra, int bgraStride) {
+    for (int row = 0; row < src.height; ++row) {
+        const uint8_t* yRow = src.y + row * src.strideY;
+        const uint8_t* uRow = src.u + (row / 2) * src.strideU;
+        const uint8_t* vRow = src.v + (row / 2) * src.strideV;
+        uint8_t* out = bgra + row * bgraStride;
+
+        for (int x = 0; x < src.width; ++x) {
+            int y = yRow[x];
+            int u = uRow[x / 2] - 128;
+            int v = vRow[x / 2] - 128;
+
+            // Same BT.601 full range coefficients as YUY2toRGB
+            out[x * 4]     = clamp(y + ((454 * u) >> 8));
+            out[x * 4 + 1] = clamp(y - ((88 * u + 183 * v) >> 8));
+            out[x * 4 + 2] = clamp(y + ((359 * v) >> 8));
+            out[x * 4 + 3] = 255;
+        }
     }
 }
 
@@ -4,12 +4,45 @@
 #include <vector>
 #include <cstdint>
 
+class ThreadPool;
+
+// Entry points used by the capture and recording path; the kernels live in PixelFormat
 namespace ColorConversion {
+    // Destination planes of a YUV 4:2:0 planar image (e.g. the planes of an encoder frame)
+    struct PlanarYUV420 {
+        uint8_t* y = nullptr;
+        uint8_t* u = nullptr;
+        uint8_t* v = nullptr;
+        int strideY = 0;
+        int strideU = 0;
+        int strideV = 0;
+        int width = 0;
+        int height = 0;
+    };
+
     // Converts YUYV (4:2:2) to RGB
-    void YUY2toRGB(const uint8_t* yuy2, uint8_t* rgb, int width, int height);
+    // When a pool is given, rows are split into bands that are converted in parallel.
+    void YUY2toRGB(const uint8_t* yuy2, uint8_t* rgb, int width, int height, ThreadPool* pool = nullptr);
     
     // Converts RGB to BGR
-    void RGBtoBGR(const uint8_t* rgb, uint8_t* bgr, int width, int height);
+    void RGBtoBGR(const uint8_t* rgb, uint8_t* bgr, int width, int height, ThreadPool* pool = nullptr);
+
+    // Repacks YUYV (4:2:2) into planar YUV 4:2:0, averaging chroma of each row pair.
+    // Luma and chroma are copied without a color space round trip, so the result keeps the
+    // camera's full range BT.601 encoding. Width and height must be even.
+    void YUY2toYUV420P(const uint8_t* yuy2, const PlanarYUV420& dst, ThreadPool* pool = nullptr);
+
+    // Converts planar YUV 4:2:0 (full range BT.601) to 32-bit BGRA with a stride in bytes
+    void YUV420PtoBGRA(const PlanarYUV420& src, uint8_t* bgra, int bgraStride);
+
+    // Converts a single RGB color to full range BT.601 YUV, used for drawing overlays in YUV
+    inline void RGBtoYUV(uint8_t r, uint8_t g, uint8_t b, uint8_t& y, uint8_t& u, uint8_t& v) {
+        int cu = (-43 * r - 85 * g + 128 * b + 128 * 256 + 128) >> 8;
+        int cv = (128 * r - 107 * g - 21 * b + 128 * 256 + 128) >> 8;
+        y = (uint8_t) ((77 * r + 150 * g + 29 * b + 128) >> 8);
+        u = (uint8_t) (cu > 255 ? 255 : cu);
+        v = (uint8_t) (cv > 255 ? 255 : cv);
+    }
 }
 
 #endif
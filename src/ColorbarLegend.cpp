@@ -0,0 +1,128 @@
+#include "ColorbarLegend.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const int GlyphWidth = 5;
+    const int GlyphHeight = 7;
+    const int GlyphAdvance = GlyphWidth + 1;
+    const int Margin = 3;
+    const int BarWidth = 8;
+
+    // Rows of the characters a label can contain, most significant of the low five bits leftmost
+    const char GlyphChars[] = "0123456789.-CFK";
+    const uint8_t Glyphs[][GlyphHeight] = {
+            {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},
+            {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},
+            {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},
+            {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},
+            {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},
+            {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},
+            {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},
+            {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},
+            {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},
+            {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C},
+            {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C},
+            {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00},
+            {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},
+            {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},
+            {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},
+    };
+}
+
+bool ColorbarLegend::set(Palette::Type palette, double low, double high, const char *unit) {
+    // Labels at readout precision, so noise below it does not count as a change
+    char lowBuf[24];
+    char highBuf[24];
+    snprintf(lowBuf, sizeof(lowBuf), "%.1f %s", low, unit);
+    snprintf(highBuf, sizeof(highBuf), "%.1f %s", high, unit);
+    if (palette == type && lowText == lowBuf && highText == highBuf) return false;
+
+    type = palette;
+    lowText = lowBuf;
+    highText = highBuf;
+    patchStale = true;
+    return true;
+}
+
+void ColorbarLegend::drawLabel(const std::string &text, int x, int y) {
+    for (char ch: text) {
+        const char *found = ch ? std::strchr(GlyphChars, ch) : nullptr;
+        if (found) {
+            const uint8_t *rows = Glyphs[found - GlyphChars];
+            for (int gy = 0; gy < GlyphHeight; ++gy) {
+                for (int gx = 0; gx < GlyphWidth; ++gx) {
+                    if (!(rows[gy] & (0x10 >> gx))) continue;
+                    uint8_t *p = &patchRGB[((y + gy) * patchWidth + x + gx) * 3];
+                    p[0] = p[1] = p[2] = 255;
+                }
+            }
+        }
+        x += GlyphAdvance;
+    }
+}
+
+void ColorbarLegend::rasterizePatch(int frameHeight) {
+    int labelWidth = (int) std::max(lowText.size(), highText.size()) * GlyphAdvance - 1;
+    // Even sizes keep the patch aligned to the chroma grid
+    patchWidth = (std::max(labelWidth, BarWidth) + 2 * Margin + 1) & ~1;
+    patchHeight = (frameHeight * 2 / 3) & ~1;
+    int barTop = Margin + GlyphHeight + Margin;
+    int barBottom = patchHeight - Margin - GlyphHeight - Margin;
+
+    patchRGB.assign((size_t) patchWidth * patchHeight * 3, 0);
+    const uint8_t *lut = Palette::table(type);
+    int barX = (patchWidth - BarWidth) / 2;
+    for (int y = barTop; y < barBottom; ++y) {
+        // Hottest at the top
+        int level = 255 - (y - barTop) * 255 / std::max(1, barBottom - barTop - 1);
+        for (int x = barX; x < barX + BarWidth; ++x) {
+            std::memcpy(&patchRGB[(y * patchWidth + x) * 3], lut + level * 3, 3);
+        }
+    }
+    int highWidth = (int) highText.size() * GlyphAdvance - 1;
+    int lowWidth = (int) lowText.size() * GlyphAdvance - 1;
+    drawLabel(highText, (patchWidth - highWidth) / 2, Margin);
+    drawLabel(lowText, (patchWidth - lowWidth) / 2, barBottom + Margin);
+
+    // Full range BT.601 like the rest of the recording, chroma averaged over each 2x2 block
+    patchY.resize((size_t) patchWidth * patchHeight);
+    patchU.resize((size_t) (patchWidth / 2) * (patchHeight / 2));
+    patchV.resize(patchU.size());
+    for (int y = 0; y < patchHeight; y += 2) {
+        for (int x = 0; x < patchWidth; x += 2) {
+            int sumU = 0, sumV = 0;
+            for (int k = 0; k < 4; ++k) {
+                int px = x + (k & 1), py = y + (k >> 1);
+                const uint8_t *p = &patchRGB[(py * patchWidth + px) * 3];
+                uint8_t cy, cu, cv;
+                ColorConversion::RGBtoYUV(p[0], p[1], p[2], cy, cu, cv);
+                patchY[py * patchWidth + px] = cy;
+                sumU += cu;
+                sumV += cv;
+            }
+            patchU[(y / 2) * (patchWidth / 2) + x / 2] = (uint8_t) ((sumU + 2) / 4);
+            patchV[(y / 2) * (patchWidth / 2) + x / 2] = (uint8_t) ((sumV + 2) / 4);
+        }
+    }
+    patchStale = false;
+}
+
+void ColorbarLegend::burn(const ColorConversion::PlanarYUV420 &planes) {
+    if (!valid()) return;
+    if (patchStale || patchHeight != ((planes.height * 2 / 3) & ~1)) rasterizePatch(planes.height);
+    if (patchWidth + 4 > planes.width) return;
+
+    // Right edge, vertically centred, on even coordinates
+    int x0 = (planes.width - patchWidth - 4) & ~1;
+    int y0 = ((planes.height - patchHeight) / 2) & ~1;
+    for (int y = 0; y < patchHeight; ++y) {
+        std::memcpy(planes.y + (y0 + y) * planes.strideY + x0, &patchY[y * patchWidth], patchWidth);
+    }
+    int halfWidth = patchWidth / 2;
+    for (int y = 0; y < patchHeight / 2; ++y) {
+        std::memcpy(planes.u + (y0 / 2 + y) * planes.strideU + x0 / 2, &patchU[y * halfWidth], halfWidth);
+        std::memcpy(planes.v + (y0 / 2 + y) * planes.strideV + x0 / 2, &patchV[y * halfWidth], halfWidth);
+    }
+}
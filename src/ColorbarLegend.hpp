@@ -0,0 +1,46 @@
+#ifndef COLORBAR_LEGEND_HPP
+#define COLORBAR_LEGEND_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ColorConversion.hpp"
+#include "Palette.hpp"
+
+// Temperature legend: the palette as a vertical gradient with the temperatures its ends stand
+// for. set() only reports a change when the palette or a formatted label differs from before,
+// so whoever draws the legend keeps its rendering cached and rebuilds it only then; the window
+// keeps a composited texture, recordings a YUV patch copied into every frame.
+class ColorbarLegend {
+public:
+    // Returns true when the palette or either label changed
+    bool set(Palette::Type palette, double low, double high, const char *unit);
+
+    bool valid() const { return !highText.empty(); }
+    Palette::Type palette() const { return type; }
+    const std::string &lowLabel() const { return lowText; }
+    const std::string &highLabel() const { return highText; }
+
+    // Copies the legend into the right edge of a YUV 4:2:0 frame. The patch, with its labels in
+    // a built-in 5x7 font, is only rasterized again after a change.
+    void burn(const ColorConversion::PlanarYUV420 &planes);
+
+private:
+    Palette::Type type = Palette::Type::IronRed;
+    std::string lowText;
+    std::string highText;
+
+    // Recording patch in 4:2:0, rebuilt when stale
+    bool patchStale = true;
+    int patchWidth = 0;
+    int patchHeight = 0;
+    std::vector<uint8_t> patchRGB;
+    std::vector<uint8_t> patchY;
+    std::vector<uint8_t> patchU;
+    std::vector<uint8_t> patchV;
+
+    void rasterizePatch(int frameHeight);
+    void drawLabel(const std::string &text, int x, int y);
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "ControlServer.hpp"
+#include "P2Pro.hpp" // For dprintf
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+ControlServer::~ControlServer() {
+    close();
+}
+
+bool ControlServer::open(const std::string &path) {
+    close();
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        dprintf("ControlServer::open() - Invalid socket path '%s'\n", path.c_str());
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    if (!removeStaleSocket(addr)) return false;
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd == -1) return false;
+    fcntl(listenFd, F_SETFD, FD_CLOEXEC);
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
+
+    if (bind(listenFd, (const sockaddr *) &addr, sizeof(addr)) != 0 || listen(listenFd, 4) != 0) {
+        dprintf("ControlServer::open() - Could not listen on %s: %s\n", path.c_str(), strerror(errno));
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    socketPath = path;
+    return true;
+}
+
+bool ControlServer::removeStaleSocket(const sockaddr_un &addr) {
+    struct stat st;
+    if (lstat(addr.sun_path, &st) != 0) return errno == ENOENT;
+    if (!S_ISSOCK(st.st_mode)) {
+        dprintf("ControlServer::open() - %s exists and is not a socket, leaving it alone\n", addr.sun_path);
+        return false;
+    }
+
+    // Only a socket nobody listens on any more is left over; a live one belongs to another instance
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe == -1) return false;
+    bool live = connect(probe, (const sockaddr *) &addr, sizeof(addr)) == 0;
+    ::close(probe);
+    if (live) {
+        dprintf("ControlServer::open() - Another instance is listening on %s\n", addr.sun_path);
+        return false;
+    }
+    return unlink(addr.sun_path) == 0 || errno == ENOENT;
+}
+
+void ControlServer::close() {
+    for (Client &c: clients) ::close(c.fd);
+    clients.clear();
+    if (listenFd != -1) {
+        ::close(listenFd);
+        unlink(socketPath.c_str());
+    }
+    listenFd = -1;
+    socketPath.clear();
+}
+
+void ControlServer::poll(int timeoutMs, const Handler &handler) {
+    if (listenFd == -1) {
+        // Nothing to wait on but the timeout; signals still cut the sleep short
+        ::poll(nullptr, 0, timeoutMs);
+        return;
+    }
+
+    pollfd fds[MaxClients + 1];
+    int count = 0;
+    fds[count++] = {listenFd, POLLIN, 0};
+    for (const Client &c: clients) fds[count++] = {c.fd, POLLIN, 0};
+
+    if (::poll(fds, count, timeoutMs) <= 0) return;
+
+    // Clients first, so the indices still match the fds array
+    for (int i = (int) clients.size() - 1; i >= 0; --i) {
+        if (!fds[i + 1].revents) continue;
+        if (!serviceClient(clients[i], handler)) {
+            ::close(clients[i].fd);
+            clients.erase(clients.begin() + i);
+        }
+    }
+
+    if (fds[0].revents & POLLIN) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd == -1) return;
+        if ((int) clients.size() >= MaxClients) {
+            ::close(fd);
+            return;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        Client c;
+        c.fd = fd;
+        clients.push_back(c);
+    }
+}
+
+bool ControlServer::serviceClient(Client &client, const Handler &handler) {
+    char buffer[512];
+    ssize_t n = read(client.fd, buffer, sizeof(buffer));
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EINTR;
+    client.pending.append(buffer, (size_t) n);
+
+    size_t newline;
+    while ((newline = client.pending.find('\n')) != std::string::npos) {
+        std::string line = client.pending.substr(0, newline);
+        client.pending.erase(0, newline + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        std::string reply = handler(line);
+        if (reply.empty() || reply.back() != '\n') reply += '\n';
+        reply += '\n';
+        // Replies are short; a client that does not read them is dropped rather than waited for
+        size_t sent = 0;
+        while (sent < reply.size()) {
+            ssize_t w = write(client.fd, reply.data() + sent, reply.size() - sent);
+            if (w <= 0) return false;
+            sent += (size_t) w;
+        }
+    }
+    return client.pending.size() <= MaxLineLength;
+}
@@ -0,0 +1,51 @@
+#ifndef CONTROL_SERVER_HPP
+#define CONTROL_SERVER_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+struct sockaddr_un;
+
+// Line-based command interface on a Unix domain socket, used to control the headless mode.
+// Clients send one command per line and get the handler's reply, which ends with an empty line,
+// e.g. `printf 'status\n' | nc -U control.sock`. Everything runs on the thread calling poll().
+class ControlServer {
+public:
+    // Returns the reply to one command line (without the newline)
+    using Handler = std::function<std::string(const std::string &command)>;
+
+    ControlServer() = default;
+    ~ControlServer();
+
+    ControlServer(const ControlServer &) = delete;
+    ControlServer &operator=(const ControlServer &) = delete;
+
+    // Replaces a stale socket file left behind by an earlier run. Fails without touching the path
+    // when it is not a socket or another instance still accepts connections on it.
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return listenFd != -1; }
+
+    // Waits up to timeoutMs for connections or input and answers every complete command line.
+    // Returns early when a signal interrupts the wait.
+    void poll(int timeoutMs, const Handler &handler);
+
+private:
+    struct Client {
+        int fd = -1;
+        std::string pending;
+    };
+
+    int listenFd = -1;
+    std::string socketPath;
+    std::vector<Client> clients;
+
+    static const int MaxClients = 8;
+    static const size_t MaxLineLength = 1024;
+
+    bool serviceClient(Client &client, const Handler &handler);
+    static bool removeStaleSocket(const sockaddr_un &addr);
+};
+
+#endif
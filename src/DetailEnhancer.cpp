@@ -0,0 +1,124 @@
+#include "DetailEnhancer.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <mutex>
+
+// All per-pixel loops below run over contiguous float rows without branches so the compiler
+// vectorizes them (SSE/AVX on x86, NEON on arm64). The only sequential dependency is the
+// running sum in the horizontal box pass.
+
+DetailEnhancer::DetailEnhancer(int w, int h)
+    : width(w), height(h),
+      guide(w * h), hSum(w * h), hSumSq(w * h), coefA(w * h), coefB(w * h) {
+}
+
+// Horizontal running box sum with replicated borders
+void DetailEnhancer::boxHorizontal(const float *src, float *dst, int y0, int y1) const {
+    const int r = params.radius;
+    for (int y = y0; y < y1; ++y) {
+        const float *s = src + y * width;
+        float *d = dst + y * width;
+
+        float acc = 0.0f;
+        for (int k = -r; k <= r; ++k) {
+            acc += s[std::min(std::max(k, 0), width - 1)];
+        }
+        d[0] = acc;
+        for (int x = 1; x < width; ++x) {
+            acc += s[std::min(x + r, width - 1)] - s[std::max(x - r - 1, 0)];
+            d[x] = acc;
+        }
+    }
+}
+
+// Vertical box sum of horizontally summed rows; dst receives the full (2r+1)^2 window sum
+void DetailEnhancer::boxVerticalSum(const float *src, float *dst, int y0, int y1) const {
+    const int r = params.radius;
+    for (int y = y0; y < y1; ++y) {
+        float *__restrict d = dst + y * width;
+        const float *__restrict first = src + std::min(std::max(y - r, 0), height - 1) * width;
+        for (int x = 0; x < width; ++x) d[x] = first[x];
+
+        for (int k = -r + 1; k <= r; ++k) {
+            const float *__restrict row = src + std::min(std::max(y + k, 0), height - 1) * width;
+            for (int x = 0; x < width; ++x) d[x] += row[x];
+        }
+    }
+}
+
+void DetailEnhancer::process(const uint16_t *thermal, uint8_t *out, ThreadPool *pool) {
+    const float norm = 1.0f / (float) ((2 * params.radius + 1) * (2 * params.radius + 1));
+    const float eps = params.epsilon;
+
+    // 1. Guide image and horizontal sums of I and I^2
+    forEachBand(pool, height, [&](int y0, int y1) {
+        for (int i = y0 * width; i < y1 * width; ++i) {
+            float v = (float) thermal[i];
+            guide[i] = v;
+            coefB[i] = v * v; // coefB doubles as scratch for I^2 here
+        }
+        boxHorizontal(guide.data(), hSum.data(), y0, y1);
+        boxHorizontal(coefB.data(), hSumSq.data(), y0, y1);
+    });
+
+    // 2. Local mean/variance and guided filter coefficients a = var / (var + eps), b = mean * (1 - a)
+    forEachBand(pool, height, [&](int y0, int y1) {
+        boxVerticalSum(hSum.data(), coefA.data(), y0, y1);
+        boxVerticalSum(hSumSq.data(), coefB.data(), y0, y1);
+        float *__restrict a = coefA.data();
+        float *__restrict b = coefB.data();
+        for (int i = y0 * width; i < y1 * width; ++i) {
+            float mean = a[i] * norm;
+            float var = std::max(b[i] * norm - mean * mean, 0.0f);
+            float ai = var / (var + eps);
+            a[i] = ai;
+            b[i] = mean - ai * mean;
+        }
+    });
+
+    // 3. Horizontal sums of the coefficients (reusing the first pass buffers)
+    forEachBand(pool, height, [&](int y0, int y1) {
+        boxHorizontal(coefA.data(), hSum.data(), y0, y1);
+        boxHorizontal(coefB.data(), hSumSq.data(), y0, y1);
+    });
+
+    // 4. Base layer = mean(a) * I + mean(b), stored in coefA; track its range for compression
+    float baseMin = FLT_MAX;
+    float baseMax = -FLT_MAX;
+    std::mutex rangeMutex;
+    forEachBand(pool, height, [&](int y0, int y1) {
+        boxVerticalSum(hSum.data(), coefA.data(), y0, y1);
+        boxVerticalSum(hSumSq.data(), coefB.data(), y0, y1);
+        float *__restrict a = coefA.data();
+        const float *__restrict b = coefB.data();
+        const float *__restrict g = guide.data();
+        float lo = FLT_MAX;
+        float hi = -FLT_MAX;
+        for (int i = y0 * width; i < y1 * width; ++i) {
+            float base = (a[i] * g[i] + b[i]) * norm;
+            a[i] = base;
+            lo = std::min(lo, base);
+            hi = std::max(hi, base);
+        }
+        std::lock_guard<std::mutex> lock(rangeMutex);
+        baseMin = std::min(baseMin, lo);
+        baseMax = std::max(baseMax, hi);
+    });
+
+    // 5. Compress the base into baseLevels, boost the detail and quantize to 8 bit.
+    // The detail gain is expressed relative to the base scale so it adapts to the scene span.
+    const float levels = std::min(std::max(params.baseLevels, 1.0f), 255.0f);
+    const float baseScale = levels / std::max(baseMax - baseMin, 1.0f);
+    const float detailScale = baseScale * params.detailGain;
+    const float offset = (255.0f - levels) * 0.5f;
+    forEachBand(pool, height, [&](int y0, int y1) {
+        const float *__restrict base = coefA.data();
+        const float *__restrict g = guide.data();
+        for (int i = y0 * width; i < y1 * width; ++i) {
+            float v = offset + (base[i] - baseMin) * baseScale + (g[i] - base[i]) * detailScale;
+            v = std::min(std::max(v, 0.0f), 255.0f);
+            out[i] = (uint8_t) (v + 0.5f);
+        }
+    });
+}
@@ -0,0 +1,48 @@
+#ifndef DETAIL_ENHANCER_HPP
+#define DETAIL_ENHANCER_HPP
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Digital detail enhancement (DDE) for the Y16 thermal plane.
+// A self-guided filter splits the image into an edge-preserving base layer and a detail layer.
+// The base layer is compressed into a limited part of the 8-bit output range and the detail
+// layer is amplified on top of it, so small temperature differences stay visible in scenes
+// with a wide overall temperature span.
+class DetailEnhancer {
+public:
+    struct Params {
+        int radius = 3;           // Box radius of the guided filter in sensor pixels
+        float epsilon = 1024.0f;  // Edge threshold as variance in raw counts^2 (32 counts = 0.5 K)
+        float detailGain = 4.0f;  // Amplification of the detail layer relative to the base layer
+        float baseLevels = 160.f; // Output levels (of 256) the base layer is compressed into
+    };
+
+    DetailEnhancer(int width, int height);
+
+    void setParams(const Params &p) { params = p; }
+    const Params &getParams() const { return params; }
+
+    // Enhances a width x height Y16 frame into an 8-bit image ready for palette lookup.
+    // Rows are processed in bands on the given pool, or inline when pool is null.
+    void process(const uint16_t *thermal, uint8_t *out, ThreadPool *pool = nullptr);
+
+private:
+    int width;
+    int height;
+    Params params;
+
+    // Working planes, allocated once
+    std::vector<float> guide;
+    std::vector<float> hSum;
+    std::vector<float> hSumSq;
+    std::vector<float> coefA;
+    std::vector<float> coefB;
+
+    void boxHorizontal(const float *src, float *dst, int y0, int y1) const;
+    void boxVerticalSum(const float *src, float *dst, int y0, int y1) const;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#include "DeviceStorage.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <sys/stat.h>
+
+namespace DeviceStorage {
+
+static bool makeDirectory(const std::string& dir) {
+    return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+// mkdir -p for the part below an existing base
+static bool makePath(const std::string& base, const std::string& sub) {
+    std::string dir = base;
+    size_t pos = 0;
+    while (pos < sub.size()) {
+        size_t next = sub.find('/', pos);
+        if (next == std::string::npos) next = sub.size();
+        dir += "/" + sub.substr(pos, next - pos);
+        if (!makeDirectory(dir)) return false;
+        pos = next + 1;
+    }
+    return true;
+}
+
+std::string directory() {
+    const char* home = std::getenv("HOME");
+#ifdef __APPLE__
+    if (!home || !*home) return "";
+    std::string base = home;
+    std::string sub = "Library/Application Support/P2ProViewer";
+#else
+    std::string base, sub;
+    const char* xdg = std::getenv("XDG_CONFIG_HOME");
+    if (xdg && *xdg) {
+        base = xdg;
+        sub = "P2ProViewer";
+    } else if (home && *home) {
+        base = home;
+        sub = ".config/P2ProViewer";
+    } else {
+        return "";
+    }
+#endif
+    if (!makePath(base, sub)) return "";
+    return base + "/" + sub;
+}
+
+std::string path(const std::string& serial, const std::string& name) {
+    std::string dir = directory();
+    if (dir.empty()) return "";
+    std::string deviceDir = serial.empty() ? "unknown" : serial;
+    if (!makePath(dir, deviceDir)) return "";
+    return dir + "/" + deviceDir + "/" + name;
+}
+
+}
@@ -0,0 +1,19 @@
+#ifndef DEVICE_STORAGE_HPP
+#define DEVICE_STORAGE_HPP
+
+#include <string>
+
+// Per-device data (bad pixel and flat-field maps, pixel statistics) and the alarm rules
+// (alarms.conf) kept in the user's configuration directory:
+// $XDG_CONFIG_HOME/P2ProViewer (~/.config/P2ProViewer) on Linux and
+// ~/Library/Application Support/P2ProViewer on macOS.
+namespace DeviceStorage {
+    // Creates the directory if needed; empty if no home directory is known
+    std::string directory();
+
+    // Path of a file belonging to the device with the given serial number, e.g.
+    // path("ABC123", "badpixels.bin") -> <directory>/ABC123/badpixels.bin
+    std::string path(const std::string& serial, const std::string& name);
+}
+
+#endif
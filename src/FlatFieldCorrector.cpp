@@ -0,0 +1,236 @@
+#include "FlatFieldCorrector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FF_NEON 1
+#define FF_SSE2 0
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FF_NEON 0
+#define FF_SSE2 1
+#else
+#define FF_NEON 0
+#define FF_SSE2 0
+#endif
+
+static const char MapMagic[4] = {'P', '2', 'F', 'F'};
+static const uint16_t UnityGain = 32768; // Q15
+
+FlatFieldCorrector::FlatFieldCorrector(int width, int height)
+        : width(width), height(height),
+          gain((size_t) width * height, UnityGain), offsetUp((size_t) width * height, 0),
+          offsetDown((size_t) width * height, 0), offset((size_t) width * height, 0),
+          column(width, 0.0f), columnUp(width, 0), columnDown(width, 0), columnError(width, 0.0f),
+          columnSamples(width, 0) {}
+
+void FlatFieldCorrector::setOffset(size_t i, int32_t value) {
+    value = std::min(std::max(value, -65535), 65535);
+    offset[i] = value;
+    offsetUp[i] = (uint16_t) std::max(value, 0);
+    offsetDown[i] = (uint16_t) std::max(-value, 0);
+}
+
+void FlatFieldCorrector::reset() {
+    std::fill(gain.begin(), gain.end(), UnityGain);
+    for (size_t i = 0; i < offset.size(); ++i) setOffset(i, 0);
+    std::fill(column.begin(), column.end(), 0.0f);
+    std::fill(columnUp.begin(), columnUp.end(), 0);
+    std::fill(columnDown.begin(), columnDown.end(), 0);
+    previousMeans.clear();
+    identity = true;
+}
+
+void FlatFieldCorrector::startCapture() {
+    captureSum.assign((size_t) width * height, 0);
+    captured = 0;
+    capturing = true;
+}
+
+bool FlatFieldCorrector::addCaptureFrame(const uint16_t *raw) {
+    if (!capturing) return false;
+    const size_t count = captureSum.size();
+    for (size_t i = 0; i < count; ++i) captureSum[i] += raw[i];
+    if (++captured < std::max(params.captureFrames, 1)) return false;
+    capturing = false;
+
+    std::vector<float> means(count);
+    double level = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        means[i] = (float) captureSum[i] / (float) captured;
+        level += means[i];
+    }
+    level /= (double) count;
+
+    // A second capture far enough from the first pins down each pixel's response slope;
+    // otherwise only the offsets are refitted around the gains already in use
+    bool twoPoint = previousMeans.size() == count && std::fabs(level - previousLevel) >= params.minTwoPointDelta;
+    for (size_t i = 0; i < count; ++i) {
+        float g = gain[i] / (float) UnityGain;
+        if (twoPoint) {
+            float response = means[i] - previousMeans[i];
+            g = response != 0.0f ? (float) (level - previousLevel) / response : 1.0f;
+            g = std::min(std::max(g, 0.5f), 1.5f);
+            gain[i] = (uint16_t) std::lround(g * UnityGain);
+            g = gain[i] / (float) UnityGain;
+        }
+        setOffset(i, (int32_t) std::lround(level - g * means[i]));
+    }
+
+    // The capture already contains the column pattern
+    std::fill(column.begin(), column.end(), 0.0f);
+    std::fill(columnUp.begin(), columnUp.end(), 0);
+    std::fill(columnDown.begin(), columnDown.end(), 0);
+
+    previousMeans.swap(means);
+    previousLevel = (float) level;
+    captureSum.clear();
+    identity = false;
+    return true;
+}
+
+void FlatFieldCorrector::apply(uint16_t *y16) {
+    if (identity && !params.columnTracking) return;
+
+    for (int y = 0; y < height; ++y) {
+        const size_t row = (size_t) y * width;
+        uint16_t *p = y16 + row;
+        const uint16_t *g = gain.data() + row;
+        const uint16_t *up = offsetUp.data() + row;
+        const uint16_t *down = offsetDown.data() + row;
+        const uint16_t *cup = columnUp.data();
+        const uint16_t *cdown = columnDown.data();
+        int x = 0;
+
+#if FF_SSE2
+        const __m128i round = _mm_set1_epi32(1 << 14);
+        const __m128i bias = _mm_set1_epi32(32768);
+        const __m128i flip = _mm_set1_epi16((short) 0x8000);
+        for (; x + 8 <= width; x += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (p + x));
+            __m128i gv = _mm_loadu_si128((const __m128i *) (g + x));
+            // 16x16 -> 32-bit products from the low and high halves, back to 16 bits with
+            // unsigned saturation via a biased signed pack
+            __m128i lo = _mm_mullo_epi16(v, gv);
+            __m128i hi = _mm_mulhi_epu16(v, gv);
+            __m128i p0 = _mm_srli_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), 15);
+            __m128i p1 = _mm_srli_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), 15);
+            v = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(p0, bias), _mm_sub_epi32(p1, bias)), flip);
+            v = _mm_subs_epu16(_mm_adds_epu16(v, _mm_loadu_si128((const __m128i *) (up + x))),
+                               _mm_loadu_si128((const __m128i *) (down + x)));
+            v = _mm_subs_epu16(_mm_adds_epu16(v, _mm_loadu_si128((const __m128i *) (cup + x))),
+                               _mm_loadu_si128((const __m128i *) (cdown + x)));
+            _mm_storeu_si128((__m128i *) (p + x), v);
+        }
+#elif FF_NEON
+        for (; x + 8 <= width; x += 8) {
+            uint16x8_t v = vld1q_u16(p + x);
+            uint16x8_t gv = vld1q_u16(g + x);
+            uint16x4_t s0 = vqrshrn_n_u32(vmull_u16(vget_low_u16(v), vget_low_u16(gv)), 15);
+            uint16x4_t s1 = vqrshrn_n_u32(vmull_u16(vget_high_u16(v), vget_high_u16(gv)), 15);
+            v = vcombine_u16(s0, s1);
+            v = vqsubq_u16(vqaddq_u16(v, vld1q_u16(up + x)), vld1q_u16(down + x));
+            v = vqsubq_u16(vqaddq_u16(v, vld1q_u16(cup + x)), vld1q_u16(cdown + x));
+            vst1q_u16(p + x, v);
+        }
+#endif
+
+        for (; x < width; ++x) {
+            int32_t v = (int32_t) std::min(((uint32_t) p[x] * g[x] + (1u << 14)) >> 15, 65535u);
+            v = std::max(std::min(v + up[x], 65535) - down[x], 0);
+            v = std::max(std::min(v + cup[x], 65535) - cdown[x], 0);
+            p[x] = (uint16_t) v;
+        }
+    }
+
+    if (params.columnTracking) updateColumns(y16);
+}
+
+void FlatFieldCorrector::updateColumns(const uint16_t *y16) {
+    // Column noise shows up as a step between a column and the average of its neighbours that
+    // persists down the whole column, while scene detail averages out. Only every 4th row is
+    // looked at (a different one each frame) and steps larger than the clamp are edges, so the
+    // estimate costs a fraction of the correction pass and never stalls the frame.
+    if (width < 3) return;
+    const int clamp = std::max(params.columnClamp, 1);
+    std::fill(columnError.begin(), columnError.end(), 0.0f);
+    std::fill(columnSamples.begin(), columnSamples.end(), 0);
+
+    for (int y = columnPhase; y < height; y += 4) {
+        const uint16_t *row = y16 + (size_t) y * width;
+        for (int x = 0; x < width; ++x) {
+            int left = row[x > 0 ? x - 1 : x + 1];
+            int right = row[x < width - 1 ? x + 1 : x - 1];
+            int d = 2 * row[x] - left - right;
+            if (std::abs(d) > 2 * clamp) continue;
+            columnError[x] += 0.5f * (float) d;
+            ++columnSamples[x];
+        }
+    }
+    columnPhase = (columnPhase + 1) & 3;
+
+    // Move each column part of the way against its error, keeping the pattern zero-mean so the
+    // absolute level stays with the radiometric calibration. The cap keeps a static scene edge
+    // from being corrected away beyond what column drift can account for.
+    const float limit = std::max(params.columnLimit, 0.0f);
+    float mean = 0.0f;
+    for (int x = 0; x < width; ++x) {
+        if (columnSamples[x] > 0) column[x] -= params.columnRate * columnError[x] / (float) columnSamples[x];
+        mean += column[x];
+    }
+    mean /= (float) width;
+    for (int x = 0; x < width; ++x) {
+        column[x] = std::min(std::max(column[x] - mean, -limit), limit);
+        int32_t c = (int32_t) std::lround(column[x]);
+        columnUp[x] = (uint16_t) std::max(c, 0);
+        columnDown[x] = (uint16_t) std::max(-c, 0);
+    }
+}
+
+bool FlatFieldCorrector::save(const std::string &path) const {
+    if (path.empty() || identity) return false;
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    uint32_t header[2] = {(uint32_t) width, (uint32_t) height};
+    bool ok = std::fwrite(MapMagic, 1, 4, f) == 4 && std::fwrite(header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(gain.data(), sizeof(uint16_t), gain.size(), f) == gain.size() &&
+              std::fwrite(offset.data(), sizeof(int32_t), offset.size(), f) == offset.size() &&
+              std::fwrite(column.data(), sizeof(float), column.size(), f) == column.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+bool FlatFieldCorrector::load(const std::string &path) {
+    if (path.empty()) return false;
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char magic[4];
+    uint32_t header[2];
+    std::vector<uint16_t> loadedGain(gain.size());
+    std::vector<int32_t> loadedOffset(offset.size());
+    std::vector<float> loadedColumn(column.size());
+    bool ok = std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, MapMagic, 4) == 0 &&
+              std::fread(header, sizeof(header), 1, f) == 1 &&
+              header[0] == (uint32_t) width && header[1] == (uint32_t) height &&
+              std::fread(loadedGain.data(), sizeof(uint16_t), loadedGain.size(), f) == loadedGain.size() &&
+              std::fread(loadedOffset.data(), sizeof(int32_t), loadedOffset.size(), f) == loadedOffset.size() &&
+              std::fread(loadedColumn.data(), sizeof(float), loadedColumn.size(), f) == loadedColumn.size();
+    std::fclose(f);
+    if (!ok) return false;
+
+    gain.swap(loadedGain);
+    for (size_t i = 0; i < offset.size(); ++i) setOffset(i, loadedOffset[i]);
+    column.swap(loadedColumn);
+    for (int x = 0; x < width; ++x) {
+        int32_t c = (int32_t) std::lround(column[x]);
+        columnUp[x] = (uint16_t) std::max(c, 0);
+        columnDown[x] = (uint16_t) std::max(-c, 0);
+    }
+    previousMeans.clear();
+    identity = false;
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef FLAT_FIELD_CORRECTOR_HPP
+#define FLAT_FIELD_CORRECTOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Host-side non-uniformity correction: out = gain * in + offset + column offset.
+// A capture averages frames of a uniform scene (lens cap, wall). One capture yields per-pixel
+// offsets; a second one at a different scene temperature also yields per-pixel gains
+// (two-point calibration). Between captures an optional scene-based estimator tracks the column
+// fixed-pattern noise that drifts in over long sessions. It is off by default: on a static
+// scene a real vertical edge looks just like column noise and would slowly be flattened, so
+// the tracked offsets are also capped to the size of actual drift.
+class FlatFieldCorrector {
+public:
+    struct Params {
+        int captureFrames = 64;
+        int minTwoPointDelta = 64; // counts (1 K) between captures needed to fit gains
+        bool columnTracking = false;
+        float columnRate = 0.02f;  // fraction of the measured column error corrected per frame
+        int columnClamp = 24;      // differences larger than this are scene edges, not noise
+        float columnLimit = 16.0f; // counts (0.25 K) a column offset may accumulate at most
+    };
+
+    FlatFieldCorrector(int width, int height);
+
+    void setParams(const Params &p) { params = p; }
+    const Params &getParams() const { return params; }
+
+    void startCapture();
+    bool isCapturing() const { return capturing; }
+
+    // Feed uncorrected frames while capturing; returns true when the capture completed and
+    // the maps were updated
+    bool addCaptureFrame(const uint16_t *raw);
+
+    // Back to an identity map
+    void reset();
+
+    // Corrects the plane in place and refines the column offsets from the result
+    void apply(uint16_t *y16);
+
+    // Binary map files as kept per device serial (see DeviceStorage)
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+private:
+    int width;
+    int height;
+    Params params;
+
+    // Maps in the form the 16-bit kernel uses: gain in Q15 (0..2) and the signed offsets split
+    // into two saturating unsigned adds
+    std::vector<uint16_t> gain;
+    std::vector<uint16_t> offsetUp;
+    std::vector<uint16_t> offsetDown;
+    std::vector<int32_t> offset;
+    bool identity = true;
+
+    std::vector<float> column;
+    std::vector<uint16_t> columnUp;
+    std::vector<uint16_t> columnDown;
+    std::vector<float> columnError;
+    std::vector<int> columnSamples;
+    int columnPhase = 0;
+
+    bool capturing = false;
+    int captured = 0;
+    std::vector<uint32_t> captureSum;
+    std::vector<float> previousMeans; // last capture, for two-point gains
+    float previousLevel = 0.0f;
+
+    void setOffset(size_t i, int32_t value);
+    void updateColumns(const uint16_t *y16);
+};
+
+#endif
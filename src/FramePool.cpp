@@ -0,0 +1,65 @@
+#include "FramePool.hpp"
+
+FramePool::FramePool(int frameCount, int width, int height) : count(frameCount), slots(new Slot[frameCount]) {
+    freeSlots.reserve(count);
+    for (int i = count - 1; i >= 0; --i) {
+        Slot &s = slots[i];
+        s.pool = this;
+        s.frame.rgb.resize((size_t) width * height * 3);
+        s.frame.thermal.resize((size_t) width * height);
+        s.frame.yuy2.resize((size_t) width * height * 2);
+        freeSlots.push_back(&s);
+    }
+}
+
+FramePool::Handle FramePool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeSlots.empty()) return Handle();
+    Slot *s = freeSlots.back();
+    freeSlots.pop_back();
+    s->refs.store(1, std::memory_order_relaxed);
+    return Handle(s);
+}
+
+int FramePool::available() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int) freeSlots.size();
+}
+
+void FramePool::release(Slot *slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeSlots.push_back(slot);
+}
+
+FramePool::Handle &FramePool::Handle::operator=(const Handle &other) {
+    if (slot != other.slot) {
+        Handle copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+FramePool::Handle &FramePool::Handle::operator=(Handle &&other) noexcept {
+    if (this != &other) {
+        reset();
+        slot = other.slot;
+        other.slot = nullptr;
+    }
+    return *this;
+}
+
+void FramePool::Handle::retain() {
+    if (slot) slot->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FramePool::Handle::reset() {
+    // The last reference returns the frame; acq_rel orders every writer's accesses before reuse
+    if (slot && slot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        slot->pool->release(slot);
+    }
+    slot = nullptr;
+}
+
+P2ProFrame *FramePool::Handle::get() const {
+    return slot ? &slot->frame : nullptr;
+}
@@ -0,0 +1,69 @@
+#ifndef FRAME_POOL_HPP
+#define FRAME_POOL_HPP
+
+#include "P2Pro.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Fixed set of preallocated camera frames shared by reference count. The capture loop fills a
+// frame it acquired, hands copies of the handle to the display and recording, and the frame
+// returns to the pool when the last handle goes away, so the buffers are allocated once at
+// startup and reused for the lifetime of the pool. The pool must outlive every handle.
+class FramePool {
+    struct Slot;
+
+public:
+    class Handle {
+    public:
+        Handle() = default;
+        Handle(const Handle &other) : slot(other.slot) { retain(); }
+        Handle(Handle &&other) noexcept : slot(other.slot) { other.slot = nullptr; }
+        ~Handle() { reset(); }
+
+        Handle &operator=(const Handle &other);
+        Handle &operator=(Handle &&other) noexcept;
+
+        void reset();
+
+        P2ProFrame *get() const;
+        P2ProFrame &operator*() const { return *get(); }
+        P2ProFrame *operator->() const { return get(); }
+        explicit operator bool() const { return slot != nullptr; }
+
+    private:
+        friend class FramePool;
+        explicit Handle(Slot *s) : slot(s) {}
+        void retain();
+
+        Slot *slot = nullptr;
+    };
+
+    FramePool(int frameCount, int width, int height);
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    // A frame nobody references; an empty handle when all of them are in use
+    Handle acquire();
+
+    int capacity() const { return count; }
+    int available() const;
+
+private:
+    struct Slot {
+        P2ProFrame frame;
+        std::atomic<int> refs{0};
+        FramePool *pool = nullptr;
+    };
+
+    int count;
+    std::unique_ptr<Slot[]> slots;
+    std::vector<Slot *> freeSlots; // reserved to count, so returning a slot never allocates
+    mutable std::mutex mutex;
+
+    void release(Slot *slot);
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "FrameStats.hpp"
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FS_NEON 1
+#define FS_SSE2 0
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FS_NEON 0
+#define FS_SSE2 1
+#else
+#define FS_NEON 0
+#define FS_SSE2 0
+#endif
+
+// The frame is reduced in blocks small enough for 16/32-bit lane accumulators. Only the block
+// holding the extreme value is rescanned to find its first position, so the arg search costs
+// two short scalar passes instead of a compare-and-branch per pixel.
+static constexpr int BlockSize = 1024;
+
+struct BlockStats {
+    int count = 0;
+    uint16_t min = 0xFFFF;
+    uint16_t max = 0;
+    uint64_t sum = 0;
+    uint64_t sumSq = 0;
+};
+
+static void scanBlock(const uint16_t *data, const uint8_t *mask, int n, BlockStats &b) {
+    int i = 0;
+    uint32_t lo = 0xFFFF, hi = 0, cnt = 0;
+    uint64_t sum = 0, sumSq = 0;
+
+#if FS_SSE2
+    // SSE2 has no unsigned 16-bit min/max: flip the sign bit and compare as signed
+    const __m128i bias = _mm_set1_epi16((short) 0x8000);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmin = _mm_set1_epi16(0x7FFF);
+    __m128i vmax = _mm_set1_epi16((short) 0x8000);
+    __m128i vsum = zero;
+    __m128i vsq = zero;
+    __m128i vskip = zero;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        __m128i forMin = v;
+        if (mask) {
+            __m128i off = _mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i *) (mask + i)), zero);
+            off = _mm_unpacklo_epi8(off, off);
+            v = _mm_andnot_si128(off, v);       // excluded -> 0 for max and sums
+            forMin = _mm_or_si128(off, forMin); // excluded -> 0xFFFF for min
+            vskip = _mm_sub_epi16(vskip, off);
+        }
+        vmax = _mm_max_epi16(vmax, _mm_xor_si128(v, bias));
+        vmin = _mm_min_epi16(vmin, _mm_xor_si128(forMin, bias));
+
+        __m128i v0 = _mm_unpacklo_epi16(v, zero);
+        __m128i v1 = _mm_unpackhi_epi16(v, zero);
+        vsum = _mm_add_epi32(vsum, _mm_add_epi32(v0, v1));
+        vsq = _mm_add_epi64(vsq, _mm_mul_epu32(v0, v0));
+        vsq = _mm_add_epi64(vsq, _mm_mul_epu32(_mm_srli_epi64(v0, 32), _mm_srli_epi64(v0, 32)));
+        vsq = _mm_add_epi64(vsq, _mm_mul_epu32(v1, v1));
+        vsq = _mm_add_epi64(vsq, _mm_mul_epu32(_mm_srli_epi64(v1, 32), _mm_srli_epi64(v1, 32)));
+    }
+    alignas(16) uint16_t mins[8], maxs[8], skips[8];
+    alignas(16) uint32_t sums[4];
+    alignas(16) uint64_t sqs[2];
+    _mm_store_si128((__m128i *) mins, _mm_xor_si128(vmin, bias));
+    _mm_store_si128((__m128i *) maxs, _mm_xor_si128(vmax, bias));
+    _mm_store_si128((__m128i *) skips, vskip);
+    _mm_store_si128((__m128i *) sums, vsum);
+    _mm_store_si128((__m128i *) sqs, vsq);
+    cnt = i;
+    for (int k = 0; k < 8; ++k) {
+        lo = std::min<uint32_t>(lo, mins[k]);
+        hi = std::max<uint32_t>(hi, maxs[k]);
+        cnt -= skips[k];
+    }
+    sum = (uint64_t) sums[0] + sums[1] + sums[2] + sums[3];
+    sumSq = sqs[0] + sqs[1];
+#elif FS_NEON
+    uint16x8_t vmin = vdupq_n_u16(0xFFFF);
+    uint16x8_t vmax = vdupq_n_u16(0);
+    uint32x4_t vsum = vdupq_n_u32(0);
+    uint64x2_t vsq = vdupq_n_u64(0);
+    uint16x8_t vcnt = vdupq_n_u16(0);
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t v = vld1q_u16(data + i);
+        uint16x8_t forMin = v;
+        if (mask) {
+            uint16x8_t keep = vcgtq_u16(vmovl_u8(vld1_u8(mask + i)), vdupq_n_u16(0));
+            v = vandq_u16(v, keep);
+            forMin = vorrq_u16(forMin, vmvnq_u16(keep));
+            vcnt = vsubq_u16(vcnt, keep);
+        }
+        vmax = vmaxq_u16(vmax, v);
+        vmin = vminq_u16(vmin, forMin);
+        vsum = vpadalq_u16(vsum, v);
+        vsq = vpadalq_u32(vsq, vmull_u16(vget_low_u16(v), vget_low_u16(v)));
+        vsq = vpadalq_u32(vsq, vmull_u16(vget_high_u16(v), vget_high_u16(v)));
+    }
+    uint16_t mins[8], maxs[8], cnts[8];
+    uint32_t sums[4];
+    uint64_t sqs[2];
+    vst1q_u16(mins, vmin);
+    vst1q_u16(maxs, vmax);
+    vst1q_u16(cnts, vcnt);
+    vst1q_u32(sums, vsum);
+    vst1q_u64(sqs, vsq);
+    cnt = mask ? 0 : i;
+    for (int k = 0; k < 8; ++k) {
+        lo = std::min<uint32_t>(lo, mins[k]);
+        hi = std::max<uint32_t>(hi, maxs[k]);
+        if (mask) cnt += cnts[k];
+    }
+    sum = (uint64_t) sums[0] + sums[1] + sums[2] + sums[3];
+    sumSq = sqs[0] + sqs[1];
+#endif
+
+    for (; i < n; ++i) {
+        if (mask && !mask[i]) continue;
+        uint32_t v = data[i];
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+        sum += v;
+        sumSq += (uint64_t) v * v;
+        cnt++;
+    }
+
+    b.count = (int) cnt;
+    b.min = (uint16_t) lo;
+    b.max = (uint16_t) hi;
+    b.sum = sum;
+    b.sumSq = sumSq;
+}
+
+static int findFirst(const uint16_t *data, const uint8_t *mask, int start, int end, uint16_t value) {
+    for (int i = start; i < end; ++i) {
+        if (data[i] == value && (!mask || mask[i])) return i;
+    }
+    return -1;
+}
+
+double FrameStats::variance() const {
+    if (count == 0) return 0.0;
+    double m = mean();
+    return std::max((double) sumSq / count - m * m, 0.0);
+}
+
+FrameStats FrameStats::compute(const uint16_t *data, int count, const uint8_t *mask) {
+    FrameStats s;
+    int minBlock = -1;
+    int maxBlock = -1;
+
+    for (int start = 0; start < count; start += BlockSize) {
+        int n = std::min(BlockSize, count - start);
+        BlockStats b;
+        scanBlock(data + start, mask ? mask + start : nullptr, n, b);
+        if (b.count == 0) continue;
+
+        if (s.count == 0 || b.min < s.min) {
+            s.min = b.min;
+            minBlock = start;
+        }
+        if (s.count == 0 || b.max > s.max) {
+            s.max = b.max;
+            maxBlock = start;
+        }
+        s.count += b.count;
+        s.sum += b.sum;
+        s.sumSq += b.sumSq;
+    }
+
+    if (s.count > 0) {
+        s.minIndex = findFirst(data, mask, minBlock, std::min(minBlock + BlockSize, count), s.min);
+        s.maxIndex = findFirst(data, mask, maxBlock, std::min(maxBlock + BlockSize, count), s.max);
+    }
+    return s;
+}
+
+// Least squares fit of f = a + b x + c y + d x^2 + e y^2 + g xy over the 3x3 neighbourhood and
+// its stationary point. Falls back to the integer position when the fit is not a maximum.
+static void refinePeak(const uint16_t *data, int width, int height, FrameStats &s) {
+    int px = s.maxIndex % width;
+    int py = s.maxIndex / width;
+    s.peakX = (float) px;
+    s.peakY = (float) py;
+    s.peakValue = (float) s.max;
+    if (px < 1 || py < 1 || px >= width - 1 || py >= height - 1) return;
+
+    float f[3][3];
+    for (int j = 0; j < 3; ++j) {
+        const uint16_t *row = data + (size_t) (py + j - 1) * width + px - 1;
+        for (int i = 0; i < 3; ++i) f[j][i] = row[i];
+    }
+
+    float left = f[0][0] + f[1][0] + f[2][0], midX = f[0][1] + f[1][1] + f[2][1], right = f[0][2] + f[1][2] + f[2][2];
+    float top = f[0][0] + f[0][1] + f[0][2], midY = f[1][0] + f[1][1] + f[1][2], bottom = f[2][0] + f[2][1] + f[2][2];
+
+    float b = (right - left) / 6.0f;
+    float c = (bottom - top) / 6.0f;
+    float d = (left + right - 2.0f * midX) / 6.0f;
+    float e = (top + bottom - 2.0f * midY) / 6.0f;
+    float g = (f[0][0] - f[0][2] - f[2][0] + f[2][2]) / 4.0f;
+    float a = (left + midX + right) / 9.0f - (2.0f / 3.0f) * (d + e);
+
+    // Maximum requires a negative definite Hessian [2d g; g 2e]
+    float det = 4.0f * d * e - g * g;
+    if (d >= 0.0f || det <= 0.0f) return;
+
+    float dx = (g * c - 2.0f * e * b) / det;
+    float dy = (g * b - 2.0f * d * c) / det;
+    if (dx < -1.0f || dx > 1.0f || dy < -1.0f || dy > 1.0f) return;
+
+    dx = std::min(std::max(dx, -0.5f), 0.5f);
+    dy = std::min(std::max(dy, -0.5f), 0.5f);
+    float peak = a + b * dx + c * dy + d * dx * dx + e * dy * dy + g * dx * dy;
+
+    s.peakX = px + dx;
+    s.peakY = py + dy;
+    s.peakValue = std::max(peak, (float) s.max);
+}
+
+FrameStats FrameStats::compute(const uint16_t *data, int width, int height, const uint8_t *mask) {
+    FrameStats s = compute(data, width * height, mask);
+    if (s.count > 0) refinePeak(data, width, height, s);
+    return s;
+}
@@ -0,0 +1,34 @@
+#ifndef FRAME_STATS_HPP
+#define FRAME_STATS_HPP
+
+#include <cstdint>
+
+// Statistics of a Y16 plane gathered in a single SIMD pass. Hot/cold spot detection, AGC and
+// alarms share one result per frame instead of each scanning the frame again.
+struct FrameStats {
+    int count = 0;        // number of pixels included (all, or those with a nonzero mask)
+    uint16_t min = 0;
+    uint16_t max = 0;
+    int minIndex = -1;    // first pixel in raster order with the minimum value
+    int maxIndex = -1;    // first pixel in raster order with the maximum value
+    uint64_t sum = 0;
+    uint64_t sumSq = 0;
+
+    // Sub-pixel position and interpolated raw value of the maximum from a quadratic fit on its
+    // 3x3 neighbourhood. Only set by the 2D overload; equal to the integer peak on the border.
+    float peakX = -1.0f;
+    float peakY = -1.0f;
+    float peakValue = 0.0f;
+
+    bool empty() const { return count == 0; }
+    double mean() const { return count ? (double) sum / count : 0.0; }
+    double variance() const;
+
+    // Pixels whose mask byte is zero are skipped when a mask is given
+    static FrameStats compute(const uint16_t *data, int count, const uint8_t *mask = nullptr);
+
+    // Same over a width x height plane, with the sub-pixel peak
+    static FrameStats compute(const uint16_t *data, int width, int height, const uint8_t *mask = nullptr);
+};
+
+#endif
@@ -101,6 +101,6 @@ bool LinuxAdapter::open_video() {
     return false;
 }
 
-bool LinuxAdapter::read_frame(std::vector<uint8_t> &frame_data) {
-    return v4l2_cap.getFrame(frame_data);
+bool LinuxAdapter::read_frame(std::vector<uint8_t> &frame_data, FrameInfo *info) {
+    return v4l2_cap.getFrame(frame_data, info ? &info->timestamp_us : nullptr, info ? &info->sequence : nullptr);
 }
@@ -22,7 +22,7 @@ public:
 
     bool open_video() override;
 
-    bool read_frame(std::vector<uint8_t> &frame_data) override;
+    bool read_frame(std::vector<uint8_t> &frame_data, FrameInfo *info = nullptr) override;
 
 private:
     libusb_context *ctx = nullptr;
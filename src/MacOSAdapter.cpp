@@ -157,6 +157,6 @@ bool MacOSAdapter::open_video() {
     return false;
 }
 
-bool MacOSAdapter::read_frame(std::vector<uint8_t>& frame_data) {
-    return native_cap.getFrame(frame_data);
+bool MacOSAdapter::read_frame(std::vector<uint8_t>& frame_data, FrameInfo* info) {
+    return native_cap.getFrame(frame_data, info ? &info->timestamp_us : nullptr, info ? &info->sequence : nullptr);
 }
@@ -20,7 +20,7 @@ public:
     bool is_connected() const override;
 
     bool open_video() override;
-    bool read_frame(std::vector<uint8_t>& frame_data) override;
+    bool read_frame(std::vector<uint8_t>& frame_data, FrameInfo* info = nullptr) override;
 
 private:
     IOUSBDeviceInterface **device_interface = nullptr;
@@ -0,0 +1,127 @@
+#include "OverlayBatch.hpp"
+#include <cmath>
+
+OverlayBatch::OverlayBatch() : layers(1) {
+}
+
+void OverlayBatch::clear() {
+    for (int i = 0; i < layerCount; ++i) {
+        layers[i].texture = nullptr;
+        layers[i].vertices.clear();
+        layers[i].indices.clear();
+    }
+    layerCount = 1;
+}
+
+bool OverlayBatch::empty() const {
+    for (int i = 0; i < layerCount; ++i) {
+        if (!layers[i].indices.empty()) return false;
+    }
+    return true;
+}
+
+OverlayBatch::Layer &OverlayBatch::layerFor(SDL_Texture *texture) {
+    if (!texture) return layers[0];
+    for (int i = 1; i < layerCount; ++i) {
+        if (layers[i].texture == texture) return layers[i];
+    }
+    if (layerCount == (int) layers.size()) layers.emplace_back();
+    Layer &layer = layers[layerCount++];
+    layer.texture = texture;
+    return layer;
+}
+
+void OverlayBatch::quad(Layer &layer, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_FPoint d, SDL_Color color) {
+    int base = (int) layer.vertices.size();
+    layer.vertices.push_back({a, color, {0.0f, 0.0f}});
+    layer.vertices.push_back({b, color, {0.0f, 0.0f}});
+    layer.vertices.push_back({c, color, {0.0f, 0.0f}});
+    layer.vertices.push_back({d, color, {0.0f, 0.0f}});
+    const int corners[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+    layer.indices.insert(layer.indices.end(), corners, corners + 6);
+}
+
+void OverlayBatch::fillRect(const SDL_Rect &rect, SDL_Color color) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    float x0 = (float) rect.x, y0 = (float) rect.y;
+    float x1 = x0 + (float) rect.w, y1 = y0 + (float) rect.h;
+    quad(layers[0], {x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}, color);
+}
+
+void OverlayBatch::drawRect(const SDL_Rect &rect, SDL_Color color) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    fillRect({rect.x, rect.y, rect.w, 1}, color);
+    if (rect.h > 1) fillRect({rect.x, rect.y + rect.h - 1, rect.w, 1}, color);
+    if (rect.h > 2) {
+        fillRect({rect.x, rect.y + 1, 1, rect.h - 2}, color);
+        if (rect.w > 1) fillRect({rect.x + rect.w - 1, rect.y + 1, 1, rect.h - 2}, color);
+    }
+}
+
+void OverlayBatch::drawLine(float x0, float y0, float x1, float y1, SDL_Color color, float width) {
+    // Pixel centres sit at +0.5, so a line between integer coordinates covers the pixels from
+    // its first to its last point inclusive
+    float cx0 = x0 + 0.5f, cy0 = y0 + 0.5f, cx1 = x1 + 0.5f, cy1 = y1 + 0.5f;
+    float dx = cx1 - cx0, dy = cy1 - cy0;
+    float length = std::sqrt(dx * dx + dy * dy);
+    float half = width * 0.5f;
+    if (length < 1e-3f) {
+        fillCircle(cx0, cy0, half, color, 4);
+        return;
+    }
+    // Extend by half the width at both ends so joined segments leave no gaps
+    float ux = dx / length * half, uy = dy / length * half;
+    float nx = -uy, ny = ux;
+    SDL_FPoint a = {cx0 - ux + nx, cy0 - uy + ny};
+    SDL_FPoint b = {cx1 + ux + nx, cy1 + uy + ny};
+    SDL_FPoint c = {cx1 + ux - nx, cy1 + uy - ny};
+    SDL_FPoint d = {cx0 - ux - nx, cy0 - uy - ny};
+    quad(layers[0], a, b, c, d, color);
+}
+
+void OverlayBatch::drawLines(const SDL_Point *points, int count, SDL_Color color, float width) {
+    for (int i = 1; i < count; ++i) {
+        drawLine((float) points[i - 1].x, (float) points[i - 1].y, (float) points[i].x, (float) points[i].y, color, width);
+    }
+}
+
+void OverlayBatch::fillCircle(float cx, float cy, float radius, SDL_Color color, int segments) {
+    Layer &layer = layers[0];
+    int centre = (int) layer.vertices.size();
+    layer.vertices.push_back({{cx, cy}, color, {0.0f, 0.0f}});
+    for (int i = 0; i < segments; ++i) {
+        float a = 2.0f * (float) M_PI * (float) i / (float) segments;
+        layer.vertices.push_back({{cx + radius * std::cos(a), cy + radius * std::sin(a)}, color, {0.0f, 0.0f}});
+    }
+    for (int i = 0; i < segments; ++i) {
+        const int fan[3] = {centre, centre + 1 + i, centre + 1 + (i + 1) % segments};
+        layer.indices.insert(layer.indices.end(), fan, fan + 3);
+    }
+}
+
+void OverlayBatch::texturedQuad(SDL_Texture *texture, const SDL_FRect &dest, const SDL_FRect &source, SDL_Color color) {
+    Layer &layer = layerFor(texture);
+    float x0 = dest.x, y0 = dest.y, x1 = dest.x + dest.w, y1 = dest.y + dest.h;
+    float u0 = source.x, v0 = source.y, u1 = source.x + source.w, v1 = source.y + source.h;
+    int base = (int) layer.vertices.size();
+    layer.vertices.push_back({{x0, y0}, color, {u0, v0}});
+    layer.vertices.push_back({{x1, y0}, color, {u1, v0}});
+    layer.vertices.push_back({{x1, y1}, color, {u1, v1}});
+    layer.vertices.push_back({{x0, y1}, color, {u0, v1}});
+    const int corners[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+    layer.indices.insert(layer.indices.end(), corners, corners + 6);
+}
+
+void OverlayBatch::submit(SDL_Renderer *renderer) {
+    SDL_BlendMode previous;
+    SDL_GetRenderDrawBlendMode(renderer, &previous);
+    // Untextured geometry is blended with the renderer's draw blend mode
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    for (int i = 0; i < layerCount; ++i) {
+        const Layer &layer = layers[i];
+        if (layer.indices.empty()) continue;
+        SDL_RenderGeometry(renderer, layer.texture, layer.vertices.data(), (int) layer.vertices.size(),
+                           layer.indices.data(), (int) layer.indices.size());
+    }
+    SDL_SetRenderDrawBlendMode(renderer, previous);
+}
@@ -0,0 +1,50 @@
+#ifndef OVERLAY_BATCH_HPP
+#define OVERLAY_BATCH_HPP
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+// Collects overlay primitives as triangles and submits them with one SDL_RenderGeometry call per
+// texture: everything untextured (lines, outlines, fills) first, then each texture in the order
+// it was first used, e.g. text from the glyph atlas on top of its background. The vertex buffers
+// are kept across frames, so building the overlay does not allocate once they have grown to size,
+// and the cost per frame stays a few calls however many annotations there are.
+class OverlayBatch {
+public:
+    OverlayBatch();
+
+    // Starts a new frame, keeping the buffers
+    void clear();
+    bool empty() const;
+
+    void fillRect(const SDL_Rect &rect, SDL_Color color);
+    // One pixel wide outline along the inside of the rectangle, like SDL_RenderDrawRect
+    void drawRect(const SDL_Rect &rect, SDL_Color color);
+    // Line of the given width centred on the segment; axis-aligned one pixel lines cover the same
+    // pixels as SDL_RenderDrawLine
+    void drawLine(float x0, float y0, float x1, float y1, SDL_Color color, float width = 1.0f);
+    void drawLines(const SDL_Point *points, int count, SDL_Color color, float width = 1.0f);
+    void fillCircle(float cx, float cy, float radius, SDL_Color color, int segments = 24);
+
+    // Textured quad; source is in texture coordinates (0..1)
+    void texturedQuad(SDL_Texture *texture, const SDL_FRect &dest, const SDL_FRect &source, SDL_Color color);
+
+    // Draws the batch with blending; the renderer's blend mode is restored afterwards
+    void submit(SDL_Renderer *renderer);
+
+private:
+    struct Layer {
+        SDL_Texture *texture = nullptr;
+        std::vector<SDL_Vertex> vertices;
+        std::vector<int> indices;
+    };
+
+    // layers[0] holds the untextured primitives; further layers are reused across frames
+    std::vector<Layer> layers;
+    int layerCount = 1;
+
+    Layer &layerFor(SDL_Texture *texture);
+    void quad(Layer &layer, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_FPoint d, SDL_Color color);
+};
+
+#endif
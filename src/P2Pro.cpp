@@ -5,6 +5,7 @@
 #include "LinuxAdapter.hpp"
 #endif
 #include "ColorConversion.hpp"
+#include "PipelineMetrics.hpp"
 #include <iostream>
 #include <stdexcept>
 #include <chrono>
@@ -60,9 +61,17 @@ void P2Pro::disconnect() {
     adapter->disconnect();
 }
 
-bool P2Pro::get_frame(P2ProFrame &out_frame) {
-    std::vector<uint8_t> raw_data;
-    if (!adapter->read_frame(raw_data)) return false;
+bool P2Pro::get_frame(P2ProFrame &out_frame, bool keep_yuy2) {
+    // The transfer buffer is a member and out_frame's vectors keep their capacity, so once the
+    // first frame has been read nothing here allocates
+    std::vector<uint8_t> &raw_data = raw_frame;
+    FrameInfo info;
+    {
+        PipelineMetrics::Timer timer(metrics, PipelineMetrics::Dequeue);
+        if (!adapter->read_frame(raw_data, &info)) return false;
+    }
+    out_frame.captureTimeUs = info.timestamp_us;
+    out_frame.sequence = info.sequence;
 
     // Expected size: 256 * 384 * 2 = 196608
     if (raw_data.size() < 196608) {
@@ -79,6 +88,7 @@ bool P2Pro::get_frame(P2ProFrame &out_frame) {
     // In Pseudo-color YUYV, U and V differ significantly.
 
     const size_t half_size = 256 * 192 * 2;
+    int64_t layout_start = metrics ? PipelineMetrics::nowUs() : 0;
     long top_uv_diff = 0;
     long bot_uv_diff = 0;
 
@@ -106,6 +116,8 @@ bool P2Pro::get_frame(P2ProFrame &out_frame) {
         thermal_ptr = raw_data.data() + half_size;
     }
 
+    if (metrics) metrics->record(PipelineMetrics::Layout, PipelineMetrics::nowUs() - layout_start);
+
     static bool first_detection = true;
     static bool last_swapped = false;
     if (first_detection || swapped != last_swapped) {
@@ -115,9 +127,20 @@ bool P2Pro::get_frame(P2ProFrame &out_frame) {
         last_swapped = swapped;
     }
 
+    // Keep the pseudo color half in its native YUYV layout only for the recorder; clear() keeps
+    // the capacity, so switching recording on later still does not allocate
+    if (keep_yuy2) {
+        out_frame.yuy2.assign(pseudo_ptr, pseudo_ptr + half_size);
+    } else {
+        out_frame.yuy2.clear();
+    }
+
     // YUYV to RGB
     out_frame.rgb.resize(256 * 192 * 3);
-    ColorConversion::YUY2toRGB(pseudo_ptr, out_frame.rgb.data(), 256, 192);
+    {
+        PipelineMetrics::Timer timer(metrics, PipelineMetrics::Convert);
+        ColorConversion::YUY2toRGB(pseudo_ptr, out_frame.rgb.data(), 256, 192);
+    }
 
     // Extract thermal data
     uint16_t *thermal_raw = (uint16_t *) thermal_ptr;
@@ -296,6 +319,17 @@ std::vector<uint8_t> P2Pro::get_device_info(DeviceInfoType dev_info) {
     return standard_cmd_read(CmdCode::GET_DEVICE_INFO_CMD, (uint32_t) dev_info, lengths[(int) dev_info]);
 }
 
+std::string P2Pro::get_serial_number() {
+    std::string serial;
+    for (auto b: get_device_info(DeviceInfoType::DEV_INFO_GET_SN)) {
+        if (b == 0) break;
+        if ((b >= '0' && b <= '9') || (b >= 'A' && b <= 'Z') || (b >= 'a' && b <= 'z') || b == '-' || b == '_') {
+            serial += (char) b;
+        }
+    }
+    return serial;
+}
+
 void P2Pro::preview_start() {
     standard_cmd_write(CmdCode::PREVIEW_START_CMD);
 }
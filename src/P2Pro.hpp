@@ -9,6 +9,8 @@
 #include <cstdarg>
 #include <memory>
 
+class PipelineMetrics;
+
 void dprintf(const char* format, ...);
 
 enum class PseudoColorTypes : uint8_t {
@@ -48,14 +50,20 @@ enum class DeviceInfoType : uint16_t {
 struct P2ProFrame {
     std::vector<uint8_t> rgb;      // 256x192x3
     std::vector<uint16_t> thermal; // 256x192
+    std::vector<uint8_t> yuy2;     // 256x192x2, pseudo color as delivered by the camera; only while recording
+    int64_t captureTimeUs = 0;     // driver capture time on the steady clock
+    uint32_t sequence = 0;         // driver frame counter
 };
 
 struct HotSpotResult {
     bool found = false;
     int x = -1;
     int y = -1;
+    float fx = -1.0f; // sub-pixel position
+    float fy = -1.0f;
     uint16_t val = 0;
-    double tempC = 0.0;
+    float peak = 0.0f; // raw value interpolated at the sub-pixel position
+    double temperature = 0.0; // in the calibration's display unit
     uint8_t r = 255, g = 0, b = 0;
 };
 
@@ -67,7 +75,12 @@ public:
     bool connect();
     void disconnect();
 
-    bool get_frame(P2ProFrame& frame);
+    // Fills frame.rgb and frame.thermal. The YUYV half is only copied into frame.yuy2 when
+    // keep_yuy2 is set (e.g. while recording); otherwise frame.yuy2 is left empty
+    bool get_frame(P2ProFrame& frame, bool keep_yuy2 = false);
+
+    // Times the dequeue, layout detection and color conversion of get_frame() when set
+    void set_metrics(PipelineMetrics* metrics) { this->metrics = metrics; }
 
     void pseudo_color_set(int preview_path, PseudoColorTypes color_type);
     PseudoColorTypes pseudo_color_get(int preview_path = 0);
@@ -76,12 +89,15 @@ public:
     uint16_t get_prop_tpd_params(PropTpdParams tpd_param);
     
     std::vector<uint8_t> get_device_info(DeviceInfoType dev_info);
+    std::string get_serial_number(); // printable part of DEV_INFO_GET_SN, empty on failure
 
     void preview_start();
     void preview_stop();
 
 private:
     std::unique_ptr<USBAdapter> adapter;
+    std::vector<uint8_t> raw_frame;
+    PipelineMetrics* metrics = nullptr;
 
     bool check_camera_ready();
     bool block_until_camera_ready(int timeout_ms = 5000);
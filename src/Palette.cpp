@@ -0,0 +1,63 @@
+#include "Palette.hpp"
+#include <array>
+#include <cstddef>
+
+namespace Palette {
+
+struct Stop {
+    int pos;
+    uint8_t r, g, b;
+};
+
+using Table = std::array<uint8_t, 256 * 3>;
+
+template <size_t N>
+static Table buildGradient(const Stop (&stops)[N]) {
+    Table t{};
+    for (size_t s = 0; s + 1 < N; ++s) {
+        const Stop &a = stops[s];
+        const Stop &b = stops[s + 1];
+        int span = b.pos - a.pos;
+        for (int i = a.pos; i <= b.pos; ++i) {
+            int f = i - a.pos;
+            t[i * 3] = (uint8_t) (a.r + (b.r - a.r) * f / span);
+            t[i * 3 + 1] = (uint8_t) (a.g + (b.g - a.g) * f / span);
+            t[i * 3 + 2] = (uint8_t) (a.b + (b.b - a.b) * f / span);
+        }
+    }
+    return t;
+}
+
+const uint8_t* table(Type type) {
+    static const Stop whiteHot[] = {{0, 0, 0, 0}, {255, 255, 255, 255}};
+    static const Stop blackHot[] = {{0, 255, 255, 255}, {255, 0, 0, 0}};
+    // Approximation of the camera's built-in PSEUDO_IRON_RED palette
+    static const Stop ironRed[] = {
+        {0, 0, 0, 16}, {48, 40, 0, 120}, {96, 150, 0, 150}, {144, 225, 60, 40},
+        {192, 250, 150, 0}, {232, 255, 225, 60}, {255, 255, 255, 230}
+    };
+    static const Stop rainbow[] = {
+        {0, 0, 0, 128}, {48, 0, 0, 255}, {96, 0, 255, 255}, {144, 0, 255, 0},
+        {192, 255, 255, 0}, {224, 255, 128, 0}, {255, 255, 0, 0}
+    };
+
+    static const Table tables[] = {
+        buildGradient(whiteHot),
+        buildGradient(blackHot),
+        buildGradient(ironRed),
+        buildGradient(rainbow)
+    };
+    return tables[(int) type].data();
+}
+
+void colorize(const uint8_t* gray, uint8_t* rgb, int count, Type type) {
+    const uint8_t* lut = table(type);
+    for (int i = 0; i < count; ++i) {
+        const uint8_t* c = lut + gray[i] * 3;
+        rgb[i * 3] = c[0];
+        rgb[i * 3 + 1] = c[1];
+        rgb[i * 3 + 2] = c[2];
+    }
+}
+
+}
@@ -0,0 +1,22 @@
+#ifndef PALETTE_HPP
+#define PALETTE_HPP
+
+#include <cstdint>
+
+// Host-side pseudo color palettes for 8-bit thermal images
+namespace Palette {
+    enum class Type {
+        WhiteHot,
+        BlackHot,
+        IronRed,
+        Rainbow
+    };
+
+    // Returns a 256 entry RGB24 lookup table (768 bytes)
+    const uint8_t* table(Type type);
+
+    // Maps each 8-bit level to RGB24 through the palette
+    void colorize(const uint8_t* gray, uint8_t* rgb, int count, Type type);
+}
+
+#endif
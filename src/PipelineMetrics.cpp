@@ -0,0 +1,96 @@
+#include "PipelineMetrics.hpp"
+
+const char *PipelineMetrics::stageName(Stage stage) {
+    switch (stage) {
+        case Dequeue: return "dequeue";
+        case Layout: return "layout";
+        case Convert: return "convert";
+        case HotSpot: return "hot spot";
+        case Upload: return "upload";
+        case Upscale: return "upscale";
+        case Present: return "present";
+        case Encode: return "encode";
+        case Latency: return "latency";
+        default: return "?";
+    }
+}
+
+int PipelineMetrics::bucketFor(int64_t micros) {
+    if (micros < LinearBuckets) return micros < 0 ? 0 : (int) micros;
+    int exponent = 63 - __builtin_clzll((uint64_t) micros); // >= 4
+    int sub = (int) (micros >> (exponent - 2)) & 3;
+    int bucket = LinearBuckets + (exponent - 4) * 4 + sub;
+    return bucket < BucketCount ? bucket : BucketCount - 1;
+}
+
+double PipelineMetrics::bucketMidpointMs(int bucket) {
+    if (bucket < LinearBuckets) return (bucket + 0.5) / 1000.0;
+    int exponent = 4 + (bucket - LinearBuckets) / 4;
+    int sub = (bucket - LinearBuckets) % 4;
+    double width = (double) (1LL << (exponent - 2));
+    double lower = (4 + sub) * width;
+    return (lower + width * 0.5) / 1000.0;
+}
+
+void PipelineMetrics::record(Stage stage, int64_t micros) {
+    bump(counts[stage][bucketFor(micros)], 1u);
+}
+
+void PipelineMetrics::frameCaptured(uint32_t sequence) {
+    // A counter that went backwards belongs to a new stream after a reconnect
+    if (haveSequence && sequence > lastSequence + 1) bump(lost, (uint64_t) (sequence - lastSequence - 1));
+    haveSequence = true;
+    lastSequence = sequence;
+    bump(captured);
+}
+
+PipelineMetrics::Summary PipelineMetrics::summarize() {
+    Summary summary;
+    int64_t now = nowUs();
+    double seconds = seenAtUs ? (double) (now - seenAtUs) / 1e6 : 0.0;
+
+    uint64_t capturedNow = captured.load(std::memory_order_relaxed);
+    uint64_t displayedNow = displayed.load(std::memory_order_relaxed);
+    uint64_t presentedNow = presented.load(std::memory_order_relaxed);
+    if (seconds > 0.0) {
+        summary.captureFps = (double) (capturedNow - seenCaptured) / seconds;
+        summary.renderFps = (double) (presentedNow - seenPresented) / seconds;
+    }
+    summary.dropped = lost.load(std::memory_order_relaxed);
+    summary.notShown = capturedNow > displayedNow ? capturedNow - displayedNow : 0;
+    seenCaptured = capturedNow;
+    seenPresented = presentedNow;
+    seenAtUs = now;
+
+    for (int s = 0; s < StageCount; ++s) {
+        uint32_t delta[BucketCount];
+        uint32_t total = 0;
+        for (int b = 0; b < BucketCount; ++b) {
+            uint32_t count = counts[s][b].load(std::memory_order_relaxed);
+            delta[b] = count - seen[s][b];
+            seen[s][b] = count;
+            total += delta[b];
+        }
+
+        StageSummary &stage = summary.stages[s];
+        stage.samples = total;
+        if (total == 0) continue;
+        // Nearest-rank percentiles, reported at the middle of their bucket
+        uint32_t rank50 = (total + 1) / 2;
+        uint32_t rank99 = total - total / 100;
+        uint32_t cumulative = 0;
+        bool have50 = false;
+        for (int b = 0; b < BucketCount; ++b) {
+            cumulative += delta[b];
+            if (!have50 && cumulative >= rank50) {
+                stage.p50Ms = bucketMidpointMs(b);
+                have50 = true;
+            }
+            if (cumulative >= rank99) {
+                stage.p99Ms = bucketMidpointMs(b);
+                break;
+            }
+        }
+    }
+    return summary;
+}
@@ -0,0 +1,105 @@
+#ifndef PIPELINE_METRICS_HPP
+#define PIPELINE_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Frame rates, lost frames and per-stage timings of the capture and display pipeline. Every
+// stage is timed by a single thread into its own histogram of log-spaced microsecond buckets,
+// so recording a sample is a relaxed atomic increment and nothing is ever locked. Only the
+// reader (the HUD) does any work: summarize() turns the counts added since its previous call
+// into rates and percentiles.
+class PipelineMetrics {
+public:
+    enum Stage {
+        Dequeue,  // waiting for and copying the driver's buffer
+        Layout,   // detecting which half of the buffer is which
+        Convert,  // YUY2 to RGB
+        HotSpot,  // frame statistics and hot spot detection
+        Upload,   // colorizing and uploading the texture
+        Upscale,  // interpolating, AGC and colorizing the visible region of a zoomed view
+        Present,  // SDL_RenderPresent, including the wait for vsync
+        Encode,   // annotating and submitting a frame to the recorder
+        Latency,  // driver capture time to the end of the first present showing the frame
+        StageCount
+    };
+
+    struct StageSummary {
+        uint32_t samples = 0;
+        double p50Ms = 0.0;
+        double p99Ms = 0.0;
+    };
+
+    struct Summary {
+        double captureFps = 0.0;
+        double renderFps = 0.0;
+        uint64_t dropped = 0;  // frames the driver produced that never reached the application
+        uint64_t notShown = 0; // frames replaced by a newer one before the display took them
+        StageSummary stages[StageCount];
+    };
+
+    static const char *stageName(Stage stage);
+
+    // Steady clock in microseconds, the time base of FrameInfo timestamps
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Writers; each stage and counter must only be written by one thread
+    void record(Stage stage, int64_t micros);
+    void frameCaptured(uint32_t sequence);
+    void frameDisplayed() { bump(displayed); }
+    void framePresented() { bump(presented); }
+
+    // Reader; covers everything recorded since the previous call
+    Summary summarize();
+
+    // Records the time from construction to destruction; does nothing without metrics
+    class Timer {
+    public:
+        Timer(PipelineMetrics *metrics, Stage stage) : metrics(metrics), stage(stage), start(metrics ? nowUs() : 0) {}
+        ~Timer() {
+            if (metrics) metrics->record(stage, nowUs() - start);
+        }
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+    private:
+        PipelineMetrics *metrics;
+        Stage stage;
+        int64_t start;
+    };
+
+private:
+    // 16 one-microsecond buckets, then four per power of two up to about 30 s
+    static const int LinearBuckets = 16;
+    static const int BucketCount = LinearBuckets + 22 * 4;
+
+    std::atomic<uint32_t> counts[StageCount][BucketCount] = {};
+    std::atomic<uint64_t> captured{0};
+    std::atomic<uint64_t> lost{0};
+    std::atomic<uint64_t> displayed{0};
+    std::atomic<uint64_t> presented{0};
+    bool haveSequence = false; // capture thread
+    uint32_t lastSequence = 0;
+
+    // Reader state: totals at the previous summarize()
+    uint32_t seen[StageCount][BucketCount] = {};
+    uint64_t seenCaptured = 0;
+    uint64_t seenPresented = 0;
+    int64_t seenAtUs = 0;
+
+    // Single writer, so a plain load and store is enough and cheaper than a read-modify-write
+    template <typename T>
+    static void bump(std::atomic<T> &counter, T amount = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static int bucketFor(int64_t micros);
+    static double bucketMidpointMs(int bucket);
+};
+
+#endif
@@ -0,0 +1,953 @@
+#include "PixelFormat.hpp"
+#include "ColorConversion.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PF_NEON 1
+#define PF_SSE2 0
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PF_NEON 0
+#define PF_SSE2 1
+#else
+#define PF_NEON 0
+#define PF_SSE2 0
+#endif
+
+namespace PixelFormat {
+
+const char* name(Format format) {
+    switch (format) {
+        case Format::YUY2: return "YUY2";
+        case Format::RGB24: return "RGB24";
+        case Format::BGR24: return "BGR24";
+        case Format::RGBA32: return "RGBA32";
+        case Format::NV12: return "NV12";
+        case Format::I420: return "I420";
+        case Format::GRAY16: return "GRAY16";
+        case Format::GRAY8: return "GRAY8";
+    }
+    return "?";
+}
+
+static int bytesPerPixel(Format format) {
+    switch (format) {
+        case Format::YUY2: return 2;
+        case Format::RGB24: return 3;
+        case Format::BGR24: return 3;
+        case Format::RGBA32: return 4;
+        case Format::GRAY16: return 2;
+        default: return 1; // luma plane of NV12/I420, GRAY8
+    }
+}
+
+static bool isSubsampled420(Format format) {
+    return format == Format::NV12 || format == Format::I420;
+}
+
+size_t imageSize(Format format, int width, int height) {
+    size_t luma = (size_t) width * height * bytesPerPixel(format);
+    if (isSubsampled420(format)) {
+        luma += 2 * (size_t) (width / 2) * (height / 2);
+    }
+    return luma;
+}
+
+Image wrap(Format format, int width, int height, const uint8_t* data) {
+    Image img;
+    img.format = format;
+    img.width = width;
+    img.height = height;
+    img.planes[0] = const_cast<uint8_t*>(data);
+    img.strides[0] = width * bytesPerPixel(format);
+
+    if (isSubsampled420(format)) {
+        uint8_t* chroma = img.planes[0] + (size_t) width * height;
+        if (format == Format::NV12) {
+            img.planes[1] = chroma;
+            img.strides[1] = (width / 2) * 2;
+        } else {
+            img.planes[1] = chroma;
+            img.planes[2] = chroma + (size_t) (width / 2) * (height / 2);
+            img.strides[1] = width / 2;
+            img.strides[2] = width / 2;
+        }
+    }
+    return img;
+}
+
+void ImageBuffer::allocate(Format format, int width, int height) {
+    storage.resize(imageSize(format, width, height));
+    image = wrap(format, width, height, storage.data());
+}
+
+// ---------------------------------------------------------------------------------------------
+// Scalar helpers (BT.601 full range, identical to the original YUY2toRGB coefficients)
+
+static inline uint8_t clamp8(int v) {
+    if (v < 0) return 0;
+    if (v > 255) return 255;
+    return (uint8_t) v;
+}
+
+static inline void yuvToRGB(int y, int u, int v, uint8_t* rgb) {
+    u -= 128;
+    v -= 128;
+    rgb[0] = clamp8(y + ((359 * v) >> 8));
+    rgb[1] = clamp8(y - ((88 * u + 183 * v) >> 8));
+    rgb[2] = clamp8(y + ((454 * u) >> 8));
+}
+
+static inline uint8_t lumaOf(const uint8_t* rgb) {
+    return (uint8_t) ((77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) >> 8);
+}
+
+// Averages the chroma of n RGB pixels given by pointers
+static inline void chromaOf(const uint8_t* const* px, int n, uint8_t& u, uint8_t& v) {
+    int r = 0, g = 0, b = 0;
+    for (int i = 0; i < n; ++i) {
+        r += px[i][0];
+        g += px[i][1];
+        b += px[i][2];
+    }
+    uint8_t y;
+    ColorConversion::RGBtoYUV((uint8_t) ((r + n / 2) / n), (uint8_t) ((g + n / 2) / n), (uint8_t) ((b + n / 2) / n),
+                              y, u, v);
+}
+
+static inline uint8_t* row(const Image& img, int plane, int y) {
+    return img.planes[plane] + (size_t) y * img.strides[plane];
+}
+
+// ---------------------------------------------------------------------------------------------
+// Format traits: unpack/pack 1 or 2 rows starting at y to/from RGB24 scratch rows.
+// 4:2:0 formats are always called with two rows.
+
+template <Format F>
+struct Traits;
+
+template <>
+struct Traits<Format::YUY2> {
+    static void toRGB(const Image& img, int y, int rows, uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* s = row(img, 0, y + r);
+            uint8_t* d = rgb + (size_t) r * img.width * 3;
+            for (int x = 0; x < img.width; x += 2, s += 4, d += 6) {
+                yuvToRGB(s[0], s[1], s[3], d);
+                yuvToRGB(s[2], s[1], s[3], d + 3);
+            }
+        }
+    }
+
+    static void fromRGB(const Image& img, int y, int rows, const uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* s = rgb + (size_t) r * img.width * 3;
+            uint8_t* d = row(img, 0, y + r);
+            for (int x = 0; x < img.width; x += 2, s += 6, d += 4) {
+                const uint8_t* px[2] = {s, s + 3};
+                d[0] = lumaOf(s);
+                d[2] = lumaOf(s + 3);
+                chromaOf(px, 2, d[1], d[3]);
+            }
+        }
+    }
+};
+
+// Packed 8-bit RGB variants differ only in channel order
+template <int R, int G, int B, int BPP>
+struct PackedRGBTraits {
+    static void toRGB(const Image& img, int y, int rows, uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* s = row(img, 0, y + r);
+            uint8_t* d = rgb + (size_t) r * img.width * 3;
+            for (int x = 0; x < img.width; ++x, s += BPP, d += 3) {
+                d[0] = s[R];
+                d[1] = s[G];
+                d[2] = s[B];
+            }
+        }
+    }
+
+    static void fromRGB(const Image& img, int y, int rows, const uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* s = rgb + (size_t) r * img.width * 3;
+            uint8_t* d = row(img, 0, y + r);
+            for (int x = 0; x < img.width; ++x, s += 3, d += BPP) {
+                d[R] = s[0];
+                d[G] = s[1];
+                d[B] = s[2];
+                if (BPP == 4) d[3] = 255;
+            }
+        }
+    }
+};
+
+template <> struct Traits<Format::RGB24> : PackedRGBTraits<0, 1, 2, 3> {};
+template <> struct Traits<Format::BGR24> : PackedRGBTraits<2, 1, 0, 3> {};
+template <> struct Traits<Format::RGBA32> : PackedRGBTraits<0, 1, 2, 4> {};
+
+// 4:2:0 formats; chroma is read from/written to plane 1 (and 2) at column x/2
+template <bool Interleaved>
+struct YUV420Traits {
+    static void chromaPtrs(const Image& img, int y, uint8_t*& u, uint8_t*& v, int& step) {
+        if (Interleaved) {
+            u = row(img, 1, y / 2);
+            v = u + 1;
+            step = 2;
+        } else {
+            u = row(img, 1, y / 2);
+            v = row(img, 2, y / 2);
+            step = 1;
+        }
+    }
+
+    static void toRGB(const Image& img, int y, int rows, uint8_t* rgb) {
+        uint8_t *u, *v;
+        int step;
+        chromaPtrs(img, y, u, v, step);
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* ys = row(img, 0, y + r);
+            uint8_t* d = rgb + (size_t) r * img.width * 3;
+            for (int x = 0; x < img.width; ++x) {
+                int c = (x / 2) * step;
+                yuvToRGB(ys[x], u[c], v[c], d + x * 3);
+            }
+        }
+    }
+
+    static void fromRGB(const Image& img, int y, int rows, const uint8_t* rgb) {
+        uint8_t *u, *v;
+        int step;
+        chromaPtrs(img, y, u, v, step);
+        const uint8_t* s0 = rgb;
+        const uint8_t* s1 = rgb + (size_t) img.width * 3;
+        uint8_t* y0 = row(img, 0, y);
+        uint8_t* y1 = row(img, 0, y + 1);
+        for (int x = 0; x < img.width; x += 2) {
+            const uint8_t* px[4] = {s0 + x * 3, s0 + x * 3 + 3, s1 + x * 3, s1 + x * 3 + 3};
+            y0[x] = lumaOf(px[0]);
+            y0[x + 1] = lumaOf(px[1]);
+            y1[x] = lumaOf(px[2]);
+            y1[x + 1] = lumaOf(px[3]);
+            chromaOf(px, 4, u[(x / 2) * step], v[(x / 2) * step]);
+        }
+        (void) rows;
+    }
+};
+
+template <> struct Traits<Format::NV12> : YUV420Traits<true> {};
+template <> struct Traits<Format::I420> : YUV420Traits<false> {};
+
+template <>
+struct Traits<Format::GRAY16> {
+    // 16-bit levels are mapped linearly to 8 bit (high byte); thermal AGC is not part of this library
+    static void toRGB(const Image& img, int y, int rows, uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint16_t* s = (const uint16_t*) row(img, 0, y + r);
+            uint8_t* d = rgb + (size_t) r * img.width * 3;
+            for (int x = 0; x < img.width; ++x, d += 3) {
+                d[0] = d[1] = d[2] = (uint8_t) (s[x] >> 8);
+            }
+        }
+    }
+
+    static void fromRGB(const Image& img, int y, int rows, const uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* s = rgb + (size_t) r * img.width * 3;
+            uint16_t* d = (uint16_t*) row(img, 0, y + r);
+            for (int x = 0; x < img.width; ++x, s += 3) {
+                d[x] = (uint16_t) (lumaOf(s) * 257);
+            }
+        }
+    }
+};
+
+template <>
+struct Traits<Format::GRAY8> {
+    static void toRGB(const Image& img, int y, int rows, uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* s = row(img, 0, y + r);
+            uint8_t* d = rgb + (size_t) r * img.width * 3;
+            for (int x = 0; x < img.width; ++x, d += 3) {
+                d[0] = d[1] = d[2] = s[x];
+            }
+        }
+    }
+
+    static void fromRGB(const Image& img, int y, int rows, const uint8_t* rgb) {
+        for (int r = 0; r < rows; ++r) {
+            const uint8_t* s = rgb + (size_t) r * img.width * 3;
+            uint8_t* d = row(img, 0, y + r);
+            for (int x = 0; x < img.width; ++x, s += 3) {
+                d[x] = lumaOf(s);
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------------------------
+// Converter<Src, Dst>::run converts rows [y0, y1), y0 even. The primary template is the generic
+// fallback; dedicated kernels are full specializations below.
+
+template <Format Src, Format Dst>
+struct Converter {
+    static constexpr bool direct = (Src == Dst);
+    static constexpr bool simd = false;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        if (Src == Dst) {
+            size_t rowBytes = (size_t) src.width * bytesPerPixel(Src);
+            for (int y = y0; y < y1; ++y) {
+                std::memcpy(row(dst, 0, y), row(src, 0, y), rowBytes);
+            }
+            if (isSubsampled420(Src)) {
+                int chromaPlanes = (Src == Format::NV12) ? 1 : 2;
+                size_t chromaBytes = (Src == Format::NV12) ? (size_t) (src.width / 2) * 2 : (size_t) src.width / 2;
+                for (int p = 1; p <= chromaPlanes; ++p) {
+                    for (int y = y0 / 2; y < y1 / 2; ++y) {
+                        std::memcpy(row(dst, p, y), row(src, p, y), chromaBytes);
+                    }
+                }
+            }
+            return;
+        }
+
+        // Scratch for two RGB24 rows, reused across calls on the same thread
+        thread_local std::vector<uint8_t> scratch;
+        scratch.resize((size_t) src.width * 3 * 2);
+
+        for (int y = y0; y < y1; y += 2) {
+            int rows = std::min(2, y1 - y);
+            Traits<Src>::toRGB(src, y, rows, scratch.data());
+            Traits<Dst>::fromRGB(dst, y, rows, scratch.data());
+        }
+    }
+};
+
+// --- YUY2 -> 4:2:0 (recording path) ------------------------------------------------------------
+
+template <bool Interleaved>
+static void yuy2To420Rows(const Image& src, const Image& dst, int y0, int y1) {
+    const int width = src.width;
+    for (int y = y0; y < y1; y += 2) {
+        const uint8_t* a = row(src, 0, y);
+        const uint8_t* b = row(src, 0, y + 1);
+        uint8_t* ya = row(dst, 0, y);
+        uint8_t* yb = row(dst, 0, y + 1);
+        uint8_t* u = row(dst, 1, y / 2);
+        uint8_t* v = Interleaved ? u + 1 : row(dst, 2, y / 2);
+        const int step = Interleaved ? 2 : 1;
+
+        int x = 0;
+#if PF_NEON
+        for (; x + 32 <= width; x += 32) {
+            uint8x16x4_t pa = vld4q_u8(a + x * 2);
+            uint8x16x4_t pb = vld4q_u8(b + x * 2);
+            uint8x16x2_t lumaA = {{pa.val[0], pa.val[2]}};
+            uint8x16x2_t lumaB = {{pb.val[0], pb.val[2]}};
+            vst2q_u8(ya + x, lumaA);
+            vst2q_u8(yb + x, lumaB);
+            uint8x16_t cu = vrhaddq_u8(pa.val[1], pb.val[1]);
+            uint8x16_t cv = vrhaddq_u8(pa.val[3], pb.val[3]);
+            if (Interleaved) {
+                uint8x16x2_t uv = {{cu, cv}};
+                vst2q_u8(u + x, uv);
+            } else {
+                vst1q_u8(u + x / 2, cu);
+                vst1q_u8(v + x / 2, cv);
+            }
+        }
+#elif PF_SSE2
+        const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+        for (; x + 16 <= width; x += 16) {
+            __m128i a0 = _mm_loadu_si128((const __m128i*) (a + x * 2));
+            __m128i a1 = _mm_loadu_si128((const __m128i*) (a + x * 2 + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i*) (b + x * 2));
+            __m128i b1 = _mm_loadu_si128((const __m128i*) (b + x * 2 + 16));
+
+            _mm_storeu_si128((__m128i*) (ya + x),
+                             _mm_packus_epi16(_mm_and_si128(a0, lowBytes), _mm_and_si128(a1, lowBytes)));
+            _mm_storeu_si128((__m128i*) (yb + x),
+                             _mm_packus_epi16(_mm_and_si128(b0, lowBytes), _mm_and_si128(b1, lowBytes)));
+
+            // U0 V0 U1 V1 ... of both rows, averaged with rounding like the scalar path
+            __m128i ca = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+            __m128i cb = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+            __m128i uv = _mm_avg_epu8(ca, cb);
+            if (Interleaved) {
+                _mm_storeu_si128((__m128i*) (u + x), uv);
+            } else {
+                __m128i zero = _mm_setzero_si128();
+                _mm_storel_epi64((__m128i*) (u + x / 2), _mm_packus_epi16(_mm_and_si128(uv, lowBytes), zero));
+                _mm_storel_epi64((__m128i*) (v + x / 2), _mm_packus_epi16(_mm_srli_epi16(uv, 8), zero));
+            }
+        }
+#endif
+        for (; x < width; x += 2) {
+            const uint8_t* pa = a + x * 2;
+            const uint8_t* pb = b + x * 2;
+            ya[x] = pa[0];
+            ya[x + 1] = pa[2];
+            yb[x] = pb[0];
+            yb[x + 1] = pb[2];
+            u[(x / 2) * step] = (uint8_t) ((pa[1] + pb[1] + 1) >> 1);
+            v[(x / 2) * step] = (uint8_t) ((pa[3] + pb[3] + 1) >> 1);
+        }
+    }
+}
+
+template <>
+struct Converter<Format::YUY2, Format::I420> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        yuy2To420Rows<false>(src, dst, y0, y1);
+    }
+};
+
+template <>
+struct Converter<Format::YUY2, Format::NV12> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        yuy2To420Rows<true>(src, dst, y0, y1);
+    }
+};
+
+// --- 3-byte pixels on SSE2 -------------------------------------------------------------------
+
+#if PF_SSE2
+// SSE2 has no byte shuffle, so 3-byte pixels are moved in and out of 4-byte lanes with masks and
+// shifts: 12 packed bytes are split into two 64-bit halves of 6 bytes, and each half into two
+// pixels of 3 bytes. The fourth byte of an expanded pixel is zero and ignored when compacting.
+
+static inline __m128i spreadRGB24(__m128i packed) {
+    const __m128i low6 = _mm_setr_epi32(-1, 0xFFFF, 0, 0);
+    const __m128i pixel0 = _mm_setr_epi32(0xFFFFFF, 0, 0xFFFFFF, 0);
+    __m128i halves = _mm_or_si128(_mm_and_si128(packed, low6),
+                                  _mm_and_si128(_mm_slli_si128(packed, 2), _mm_slli_si128(low6, 8)));
+    return _mm_or_si128(_mm_and_si128(halves, pixel0), _mm_slli_epi64(_mm_andnot_si128(pixel0, halves), 8));
+}
+
+static inline __m128i compactRGB24(__m128i pixels) {
+    const __m128i low6 = _mm_setr_epi32(-1, 0xFFFF, 0, 0);
+    const __m128i pixel0 = _mm_setr_epi32(0xFFFFFF, 0, 0xFFFFFF, 0);
+    const __m128i pixel1 = _mm_setr_epi32(0, 0xFFFFFF, 0, 0xFFFFFF);
+    __m128i halves = _mm_or_si128(_mm_and_si128(pixels, pixel0), _mm_srli_epi64(_mm_and_si128(pixels, pixel1), 8));
+    return _mm_or_si128(_mm_and_si128(halves, low6), _mm_srli_si128(_mm_andnot_si128(low6, halves), 2));
+}
+
+// 8 pixels, 24 bytes, without reading or writing past them
+static inline void loadRGB24x8(const uint8_t* s, __m128i& p0, __m128i& p1) {
+    __m128i a = _mm_loadu_si128((const __m128i*) s);
+    __m128i b = _mm_loadl_epi64((const __m128i*) (s + 16));
+    p0 = spreadRGB24(a);
+    p1 = spreadRGB24(_mm_or_si128(_mm_srli_si128(a, 12), _mm_slli_si128(b, 4)));
+}
+
+static inline void storeRGB24x8(uint8_t* d, __m128i p0, __m128i p1) {
+    __m128i c0 = compactRGB24(p0);
+    __m128i c1 = compactRGB24(p1);
+    _mm_storeu_si128((__m128i*) d, _mm_or_si128(c0, _mm_slli_si128(c1, 12)));
+    _mm_storel_epi64((__m128i*) (d + 16), _mm_srli_si128(c1, 4));
+}
+
+// Selects the bytes of one channel of packed 3-byte pixels in the 16 bytes from offset
+static inline __m128i channelMask(int offset, int channel) {
+    alignas(16) uint8_t mask[16];
+    for (int i = 0; i < 16; ++i) mask[i] = (offset + i) % 3 == channel ? 0xFF : 0;
+    return _mm_load_si128((const __m128i*) mask);
+}
+
+// Exchanges bytes 0 and 2 of every 4-byte pixel
+static inline __m128i swapRB32(__m128i p) {
+    const __m128i keep = _mm_set1_epi32((int) 0xFF00FF00);
+    const __m128i low = _mm_set1_epi32(0xFF);
+    return _mm_or_si128(_mm_and_si128(p, keep),
+                        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), low),
+                                     _mm_slli_epi32(_mm_and_si128(p, low), 16)));
+}
+#endif
+
+// --- YUY2 -> RGB (capture/display path) -------------------------------------------------------
+
+template <int BPP>
+static void yuy2ToRGBRows(const Image& src, const Image& dst, int y0, int y1) {
+    const int width = src.width;
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* s = row(src, 0, y);
+        uint8_t* d = row(dst, 0, y);
+
+        int x = 0;
+#if PF_NEON
+        for (; x + 16 <= width; x += 16) {
+            uint8x8x4_t p = vld4_u8(s + x * 2); // Y0[8] U[8] Y1[8] V[8]
+            int16x8_t u = vreinterpretq_s16_u16(vsubl_u8(p.val[1], vdup_n_u8(128)));
+            int16x8_t v = vreinterpretq_s16_u16(vsubl_u8(p.val[3], vdup_n_u8(128)));
+
+            int16x8_t rOff = vcombine_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(v), 359), 8),
+                                          vshrn_n_s32(vmull_n_s16(vget_high_s16(v), 359), 8));
+            int16x8_t gOff = vcombine_s16(
+                vshrn_n_s32(vmlal_n_s16(vmull_n_s16(vget_low_s16(u), 88), vget_low_s16(v), 183), 8),
+                vshrn_n_s32(vmlal_n_s16(vmull_n_s16(vget_high_s16(u), 88), vget_high_s16(v), 183), 8));
+            int16x8_t bOff = vcombine_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(u), 454), 8),
+                                          vshrn_n_s32(vmull_n_s16(vget_high_s16(u), 454), 8));
+
+            int16x8_t y0v = vreinterpretq_s16_u16(vmovl_u8(p.val[0]));
+            int16x8_t y1v = vreinterpretq_s16_u16(vmovl_u8(p.val[2]));
+
+            // Even and odd pixels share chroma; zip them back into pixel order
+            uint8x8x2_t r = vzip_u8(vqmovun_s16(vaddq_s16(y0v, rOff)), vqmovun_s16(vaddq_s16(y1v, rOff)));
+            uint8x8x2_t g = vzip_u8(vqmovun_s16(vsubq_s16(y0v, gOff)), vqmovun_s16(vsubq_s16(y1v, gOff)));
+            uint8x8x2_t b = vzip_u8(vqmovun_s16(vaddq_s16(y0v, bOff)), vqmovun_s16(vaddq_s16(y1v, bOff)));
+
+            if (BPP == 3) {
+                uint8x16x3_t out = {{vcombine_u8(r.val[0], r.val[1]), vcombine_u8(g.val[0], g.val[1]),
+                                     vcombine_u8(b.val[0], b.val[1])}};
+                vst3q_u8(d + x * 3, out);
+            } else {
+                uint8x16x4_t out = {{vcombine_u8(r.val[0], r.val[1]), vcombine_u8(g.val[0], g.val[1]),
+                                     vcombine_u8(b.val[0], b.val[1]), vdupq_n_u8(255)}};
+                vst4q_u8(d + x * 4, out);
+            }
+        }
+#elif PF_SSE2
+        {
+            const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+            const __m128i bias = _mm_set1_epi16(128);
+            const __m128i rCoef = _mm_setr_epi16(0, 359, 0, 359, 0, 359, 0, 359);
+            const __m128i gCoef = _mm_setr_epi16(88, 183, 88, 183, 88, 183, 88, 183);
+            const __m128i bCoef = _mm_setr_epi16(454, 0, 454, 0, 454, 0, 454, 0);
+            const __m128i alpha = _mm_set1_epi8((char) 255);
+            for (; x + 8 <= width; x += 8) {
+                __m128i p = _mm_loadu_si128((const __m128i*) (s + x * 2));
+                __m128i luma = _mm_and_si128(p, lowBytes);                        // Y0..Y7
+                __m128i chroma = _mm_sub_epi16(_mm_srli_epi16(p, 8), bias); // U0 V0 U1 V1 ...
+
+                // Exact (88u + 183v) >> 8 etc. per chroma pair, then duplicated for both pixels
+                __m128i rPair = _mm_srai_epi32(_mm_madd_epi16(chroma, rCoef), 8);
+                __m128i gPair = _mm_srai_epi32(_mm_madd_epi16(chroma, gCoef), 8);
+                __m128i bPair = _mm_srai_epi32(_mm_madd_epi16(chroma, bCoef), 8);
+                __m128i rOff = _mm_packs_epi32(rPair, rPair);
+                __m128i gOff = _mm_packs_epi32(gPair, gPair);
+                __m128i bOff = _mm_packs_epi32(bPair, bPair);
+                rOff = _mm_unpacklo_epi16(rOff, rOff);
+                gOff = _mm_unpacklo_epi16(gOff, gOff);
+                bOff = _mm_unpacklo_epi16(bOff, bOff);
+
+                __m128i r8 = _mm_packus_epi16(_mm_add_epi16(luma, rOff), _mm_setzero_si128());
+                __m128i g8 = _mm_packus_epi16(_mm_sub_epi16(luma, gOff), _mm_setzero_si128());
+                __m128i b8 = _mm_packus_epi16(_mm_add_epi16(luma, bOff), _mm_setzero_si128());
+
+                __m128i rg = _mm_unpacklo_epi8(r8, g8);
+                __m128i ba = _mm_unpacklo_epi8(b8, alpha);
+                if (BPP == 3) {
+                    storeRGB24x8(d + x * 3, _mm_unpacklo_epi16(rg, ba), _mm_unpackhi_epi16(rg, ba));
+                } else {
+                    _mm_storeu_si128((__m128i*) (d + x * 4), _mm_unpacklo_epi16(rg, ba));
+                    _mm_storeu_si128((__m128i*) (d + x * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+                }
+            }
+        }
+#endif
+        for (; x < width; x += 2) {
+            const uint8_t* p = s + x * 2;
+            uint8_t* o = d + x * BPP;
+            yuvToRGB(p[0], p[1], p[3], o);
+            yuvToRGB(p[2], p[1], p[3], o + BPP);
+            if (BPP == 4) {
+                o[3] = 255;
+                o[7] = 255;
+            }
+        }
+    }
+}
+
+template <>
+struct Converter<Format::YUY2, Format::RGB24> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        yuy2ToRGBRows<3>(src, dst, y0, y1);
+    }
+};
+
+template <>
+struct Converter<Format::YUY2, Format::RGBA32> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        yuy2ToRGBRows<4>(src, dst, y0, y1);
+    }
+};
+
+// --- Packed RGB reordering -------------------------------------------------------------------
+
+// Swaps R and B of 3-byte pixels (RGB24 <-> BGR24)
+static void swapRBRows(const Image& src, const Image& dst, int y0, int y1) {
+#if PF_SSE2
+    // Byte masks of the first, second and last channel within each of three consecutive vectors
+    __m128i first[3], green[3], last[3];
+    for (int k = 0; k < 3; ++k) {
+        first[k] = channelMask(k * 16, 0);
+        green[k] = channelMask(k * 16, 1);
+        last[k] = channelMask(k * 16, 2);
+    }
+#endif
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* s = row(src, 0, y);
+        uint8_t* d = row(dst, 0, y);
+        int x = 0;
+#if PF_NEON
+        for (; x + 16 <= src.width; x += 16) {
+            uint8x16x3_t p = vld3q_u8(s + x * 3);
+            uint8x16_t t = p.val[0];
+            p.val[0] = p.val[2];
+            p.val[2] = t;
+            vst3q_u8(d + x * 3, p);
+        }
+#elif PF_SSE2
+        // 16 pixels span three vectors in which the byte positions of R, G and B repeat, so each
+        // output vector merges its input shifted two bytes either way with the neighbouring one
+        for (; x + 16 <= src.width; x += 16) {
+            __m128i v[3];
+            for (int k = 0; k < 3; ++k) v[k] = _mm_loadu_si128((const __m128i*) (s + x * 3 + k * 16));
+            for (int k = 0; k < 3; ++k) {
+                __m128i next = _mm_srli_si128(v[k], 2);
+                __m128i prev = _mm_slli_si128(v[k], 2);
+                if (k < 2) next = _mm_or_si128(next, _mm_slli_si128(v[k + 1], 14));
+                if (k > 0) prev = _mm_or_si128(prev, _mm_srli_si128(v[k - 1], 14));
+                __m128i out = _mm_or_si128(_mm_and_si128(v[k], green[k]),
+                                           _mm_or_si128(_mm_and_si128(next, first[k]), _mm_and_si128(prev, last[k])));
+                _mm_storeu_si128((__m128i*) (d + x * 3 + k * 16), out);
+            }
+        }
+#endif
+        for (; x < src.width; ++x) {
+            d[x * 3] = s[x * 3 + 2];
+            d[x * 3 + 1] = s[x * 3 + 1];
+            d[x * 3 + 2] = s[x * 3];
+        }
+    }
+}
+
+template <>
+struct Converter<Format::RGB24, Format::BGR24> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        swapRBRows(src, dst, y0, y1);
+    }
+};
+
+template <>
+struct Converter<Format::BGR24, Format::RGB24> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        swapRBRows(src, dst, y0, y1);
+    }
+};
+
+// Expands 3-byte pixels to RGBA, optionally swapping R and B
+template <bool Swap>
+static void expandRGBRows(const Image& src, const Image& dst, int y0, int y1) {
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* s = row(src, 0, y);
+        uint8_t* d = row(dst, 0, y);
+        int x = 0;
+#if PF_NEON
+        for (; x + 16 <= src.width; x += 16) {
+            uint8x16x3_t p = vld3q_u8(s + x * 3);
+            uint8x16x4_t out = {{Swap ? p.val[2] : p.val[0], p.val[1], Swap ? p.val[0] : p.val[2], vdupq_n_u8(255)}};
+            vst4q_u8(d + x * 4, out);
+        }
+#elif PF_SSE2
+        const __m128i alpha = _mm_set1_epi32((int) 0xFF000000);
+        for (; x + 8 <= src.width; x += 8) {
+            __m128i p0, p1;
+            loadRGB24x8(s + x * 3, p0, p1);
+            if (Swap) {
+                p0 = swapRB32(p0);
+                p1 = swapRB32(p1);
+            }
+            _mm_storeu_si128((__m128i*) (d + x * 4), _mm_or_si128(p0, alpha));
+            _mm_storeu_si128((__m128i*) (d + x * 4 + 16), _mm_or_si128(p1, alpha));
+        }
+#endif
+        for (; x < src.width; ++x) {
+            d[x * 4] = s[x * 3 + (Swap ? 2 : 0)];
+            d[x * 4 + 1] = s[x * 3 + 1];
+            d[x * 4 + 2] = s[x * 3 + (Swap ? 0 : 2)];
+            d[x * 4 + 3] = 255;
+        }
+    }
+}
+
+template <>
+struct Converter<Format::RGB24, Format::RGBA32> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        expandRGBRows<false>(src, dst, y0, y1);
+    }
+};
+
+template <>
+struct Converter<Format::BGR24, Format::RGBA32> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        expandRGBRows<true>(src, dst, y0, y1);
+    }
+};
+
+// --- Gray -------------------------------------------------------------------------------------
+
+template <>
+struct Converter<Format::GRAY16, Format::GRAY8> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const uint16_t* s = (const uint16_t*) row(src, 0, y);
+            uint8_t* d = row(dst, 0, y);
+            int x = 0;
+#if PF_NEON
+            for (; x + 16 <= src.width; x += 16) {
+                uint8x8_t lo = vshrn_n_u16(vld1q_u16(s + x), 8);
+                uint8x8_t hi = vshrn_n_u16(vld1q_u16(s + x + 8), 8);
+                vst1q_u8(d + x, vcombine_u8(lo, hi));
+            }
+#elif PF_SSE2
+            for (; x + 16 <= src.width; x += 16) {
+                __m128i lo = _mm_srli_epi16(_mm_loadu_si128((const __m128i*) (s + x)), 8);
+                __m128i hi = _mm_srli_epi16(_mm_loadu_si128((const __m128i*) (s + x + 8)), 8);
+                _mm_storeu_si128((__m128i*) (d + x), _mm_packus_epi16(lo, hi));
+            }
+#endif
+            for (; x < src.width; ++x) {
+                d[x] = (uint8_t) (s[x] >> 8);
+            }
+        }
+    }
+};
+
+template <>
+struct Converter<Format::GRAY8, Format::RGBA32> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* s = row(src, 0, y);
+            uint8_t* d = row(dst, 0, y);
+            int x = 0;
+#if PF_NEON
+            for (; x + 16 <= src.width; x += 16) {
+                uint8x16_t g = vld1q_u8(s + x);
+                uint8x16x4_t out = {{g, g, g, vdupq_n_u8(255)}};
+                vst4q_u8(d + x * 4, out);
+            }
+#elif PF_SSE2
+            const __m128i alpha = _mm_set1_epi8((char) 255);
+            for (; x + 16 <= src.width; x += 16) {
+                __m128i g = _mm_loadu_si128((const __m128i*) (s + x));
+                __m128i gg0 = _mm_unpacklo_epi8(g, g);
+                __m128i gg1 = _mm_unpackhi_epi8(g, g);
+                __m128i ga0 = _mm_unpacklo_epi8(g, alpha);
+                __m128i ga1 = _mm_unpackhi_epi8(g, alpha);
+                _mm_storeu_si128((__m128i*) (d + x * 4), _mm_unpacklo_epi16(gg0, ga0));
+                _mm_storeu_si128((__m128i*) (d + x * 4 + 16), _mm_unpackhi_epi16(gg0, ga0));
+                _mm_storeu_si128((__m128i*) (d + x * 4 + 32), _mm_unpacklo_epi16(gg1, ga1));
+                _mm_storeu_si128((__m128i*) (d + x * 4 + 48), _mm_unpackhi_epi16(gg1, ga1));
+            }
+#endif
+            for (; x < src.width; ++x) {
+                d[x * 4] = d[x * 4 + 1] = d[x * 4 + 2] = s[x];
+                d[x * 4 + 3] = 255;
+            }
+        }
+    }
+};
+
+template <>
+struct Converter<Format::GRAY8, Format::RGB24> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* s = row(src, 0, y);
+            uint8_t* d = row(dst, 0, y);
+            int x = 0;
+#if PF_NEON
+            for (; x + 16 <= src.width; x += 16) {
+                uint8x16_t g = vld1q_u8(s + x);
+                uint8x16x3_t out = {{g, g, g}};
+                vst3q_u8(d + x * 3, out);
+            }
+#elif PF_SSE2
+            for (; x + 16 <= src.width; x += 16) {
+                __m128i g = _mm_loadu_si128((const __m128i*) (s + x));
+                __m128i gg0 = _mm_unpacklo_epi8(g, g);
+                __m128i gg1 = _mm_unpackhi_epi8(g, g);
+                storeRGB24x8(d + x * 3, _mm_unpacklo_epi16(gg0, gg0), _mm_unpackhi_epi16(gg0, gg0));
+                storeRGB24x8(d + x * 3 + 24, _mm_unpacklo_epi16(gg1, gg1), _mm_unpackhi_epi16(gg1, gg1));
+            }
+#endif
+            for (; x < src.width; ++x) {
+                d[x * 3] = d[x * 3 + 1] = d[x * 3 + 2] = s[x];
+            }
+        }
+    }
+};
+
+// --- 4:2:0 layout changes ---------------------------------------------------------------------
+
+static void copyLumaRows(const Image& src, const Image& dst, int y0, int y1) {
+    for (int y = y0; y < y1; ++y) {
+        std::memcpy(row(dst, 0, y), row(src, 0, y), src.width);
+    }
+}
+
+template <>
+struct Converter<Format::I420, Format::NV12> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        copyLumaRows(src, dst, y0, y1);
+        const int cw = src.width / 2;
+        for (int y = y0 / 2; y < y1 / 2; ++y) {
+            const uint8_t* u = row(src, 1, y);
+            const uint8_t* v = row(src, 2, y);
+            uint8_t* uv = row(dst, 1, y);
+            int x = 0;
+#if PF_NEON
+            for (; x + 16 <= cw; x += 16) {
+                uint8x16x2_t p = {{vld1q_u8(u + x), vld1q_u8(v + x)}};
+                vst2q_u8(uv + x * 2, p);
+            }
+#elif PF_SSE2
+            for (; x + 16 <= cw; x += 16) {
+                __m128i pu = _mm_loadu_si128((const __m128i*) (u + x));
+                __m128i pv = _mm_loadu_si128((const __m128i*) (v + x));
+                _mm_storeu_si128((__m128i*) (uv + x * 2), _mm_unpacklo_epi8(pu, pv));
+                _mm_storeu_si128((__m128i*) (uv + x * 2 + 16), _mm_unpackhi_epi8(pu, pv));
+            }
+#endif
+            for (; x < cw; ++x) {
+                uv[x * 2] = u[x];
+                uv[x * 2 + 1] = v[x];
+            }
+        }
+    }
+};
+
+template <>
+struct Converter<Format::NV12, Format::I420> {
+    static constexpr bool direct = true;
+    static constexpr bool simd = PF_NEON || PF_SSE2;
+
+    static void run(const Image& src, const Image& dst, int y0, int y1) {
+        copyLumaRows(src, dst, y0, y1);
+        const int cw = src.width / 2;
+        for (int y = y0 / 2; y < y1 / 2; ++y) {
+            const uint8_t* uv = row(src, 1, y);
+            uint8_t* u = row(dst, 1, y);
+            uint8_t* v = row(dst, 2, y);
+            int x = 0;
+#if PF_NEON
+            for (; x + 16 <= cw; x += 16) {
+                uint8x16x2_t p = vld2q_u8(uv + x * 2);
+                vst1q_u8(u + x, p.val[0]);
+                vst1q_u8(v + x, p.val[1]);
+            }
+#elif PF_SSE2
+            const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+            for (; x + 16 <= cw; x += 16) {
+                __m128i p0 = _mm_loadu_si128((const __m128i*) (uv + x * 2));
+                __m128i p1 = _mm_loadu_si128((const __m128i*) (uv + x * 2 + 16));
+                _mm_storeu_si128((__m128i*) (u + x),
+                                 _mm_packus_epi16(_mm_and_si128(p0, lowBytes), _mm_and_si128(p1, lowBytes)));
+                _mm_storeu_si128((__m128i*) (v + x), _mm_packus_epi16(_mm_srli_epi16(p0, 8), _mm_srli_epi16(p1, 8)));
+            }
+#endif
+            for (; x < cw; ++x) {
+                u[x] = uv[x * 2];
+                v[x] = uv[x * 2 + 1];
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------------------------
+// Runtime dispatch over all FormatCount x FormatCount pairs
+
+using RunFn = void (*)(const Image&, const Image&, int, int);
+
+struct KernelEntry {
+    RunFn run;
+    bool direct;
+    bool simd;
+};
+
+template <size_t... I>
+static constexpr std::array<KernelEntry, sizeof...(I)> makeKernelTable(std::index_sequence<I...>) {
+    return {{KernelEntry{
+        &Converter<(Format) (I / FormatCount), (Format) (I % FormatCount)>::run,
+        Converter<(Format) (I / FormatCount), (Format) (I % FormatCount)>::direct,
+        Converter<(Format) (I / FormatCount), (Format) (I % FormatCount)>::simd}...}};
+}
+
+static const std::array<KernelEntry, FormatCount * FormatCount> kernels =
+    makeKernelTable(std::make_index_sequence<FormatCount * FormatCount>{});
+
+static const KernelEntry& kernel(Format src, Format dst) {
+    return kernels[(int) src * FormatCount + (int) dst];
+}
+
+bool hasSimdKernel(Format src, Format dst) {
+    return kernel(src, dst).simd;
+}
+
+bool hasDirectKernel(Format src, Format dst) {
+    return kernel(src, dst).direct;
+}
+
+static bool needsEvenWidth(Format f) {
+    return f == Format::YUY2 || isSubsampled420(f);
+}
+
+bool convert(const Image& src, const Image& dst, ThreadPool* pool) {
+    if (src.width != dst.width || src.height != dst.height) return false;
+    if (src.width <= 0 || src.height <= 0) return false;
+    if ((needsEvenWidth(src.format) || needsEvenWidth(dst.format)) && (src.width & 1)) return false;
+    if ((isSubsampled420(src.format) || isSubsampled420(dst.format)) && (src.height & 1)) return false;
+
+    RunFn run = kernel(src.format, dst.format).run;
+    int pairs = (src.height + 1) / 2;
+
+    // Bands are made of row pairs so 4:2:0 chroma rows are never shared between bands
+    forEachBand(pool, pairs, [&](int p0, int p1) {
+        run(src, dst, p0 * 2, std::min(p1 * 2, src.height));
+    }, 8);
+    return true;
+}
+
+}
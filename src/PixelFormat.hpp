@@ -0,0 +1,65 @@
+#ifndef PIXEL_FORMAT_HPP
+#define PIXEL_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Conversion between the pixel formats that move through the capture, display and recording
+// pipeline. Every source/destination pair has a kernel: pairs with a dedicated (SIMD) kernel
+// use it, all others go through a generic path that unpacks row pairs to RGB24 and packs
+// them into the destination. YUV formats are full range BT.601, like the camera's output.
+namespace PixelFormat {
+    enum class Format {
+        YUY2,   // packed 4:2:2 Y0 U Y1 V (camera pseudo color)
+        RGB24,  // packed R G B
+        BGR24,  // packed B G R
+        RGBA32, // packed R G B A, byte order (SDL_PIXELFORMAT_RGBA32)
+        NV12,   // Y plane + interleaved UV plane, 4:2:0 (hardware encoders)
+        I420,   // Y, U and V planes, 4:2:0 (YUV420P, FFmpeg encoders)
+        GRAY16, // 16-bit luminance in native byte order (thermal Y16)
+        GRAY8   // 8-bit luminance
+    };
+
+    constexpr int FormatCount = 8;
+
+    const char* name(Format format);
+
+    // Non-owning view of an image; strides are in bytes
+    struct Image {
+        Format format = Format::RGB24;
+        int width = 0;
+        int height = 0;
+        uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+        int strides[3] = {0, 0, 0};
+    };
+
+    // Tightly packed storage for an image of the given format
+    struct ImageBuffer {
+        std::vector<uint8_t> storage;
+        Image image;
+
+        void allocate(Format format, int width, int height);
+    };
+
+    // Wraps caller-owned, tightly packed memory (single allocation, planes back to back)
+    Image wrap(Format format, int width, int height, const uint8_t* data);
+
+    // Number of bytes of a tightly packed image
+    size_t imageSize(Format format, int width, int height);
+
+    // Converts src into dst, which must have the same dimensions. Chroma subsampled formats
+    // need an even width (YUY2, NV12, I420) and height (NV12, I420). Returns false if the
+    // images are incompatible. Row bands are converted in parallel when a pool is given.
+    bool convert(const Image& src, const Image& dst, ThreadPool* pool = nullptr);
+
+    // Whether the pair is served by a dedicated SIMD kernel on this build
+    bool hasSimdKernel(Format src, Format dst);
+
+    // Whether the pair has a dedicated kernel instead of the RGB24 round trip
+    bool hasDirectKernel(Format src, Format dst);
+}
+
+#endif
@@ -0,0 +1,311 @@
+#include "PixelStatsAccumulator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PS_NEON 1
+#define PS_SSE2 0
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PS_NEON 0
+#define PS_SSE2 1
+#else
+#define PS_NEON 0
+#define PS_SSE2 0
+#endif
+
+namespace {
+    const char SnapshotMagic[4] = {'P', '2', 'P', 'S'};
+    const uint32_t SnapshotVersion = 1;
+
+    struct SnapshotHeader {
+        char magic[4];
+        uint32_t width;
+        uint32_t height;
+        uint32_t version;
+        uint64_t count;
+        int64_t epochMs;
+    };
+
+    // Planes follow the header in this order: mean and M2 (double), time of max (uint32),
+    // min and max (uint16)
+    size_t snapshotSize(size_t count) {
+        return sizeof(SnapshotHeader) + count * (2 * sizeof(double) + sizeof(uint32_t) + 2 * sizeof(uint16_t));
+    }
+}
+
+PixelStatsAccumulator::PixelStatsAccumulator(int width, int height)
+        : width(width), height(height),
+          batchMean((size_t) width * height), batchM2((size_t) width * height),
+          mean((size_t) width * height), m2((size_t) width * height),
+          minValue((size_t) width * height), maxValue((size_t) width * height), maxTime((size_t) width * height) {
+    reset();
+}
+
+PixelStatsAccumulator::~PixelStatsAccumulator() {
+    closeSnapshot();
+}
+
+void PixelStatsAccumulator::reset() {
+    std::fill(batchMean.begin(), batchMean.end(), 0.0f);
+    std::fill(batchM2.begin(), batchM2.end(), 0.0f);
+    std::fill(mean.begin(), mean.end(), 0.0);
+    std::fill(m2.begin(), m2.end(), 0.0);
+    std::fill(minValue.begin(), minValue.end(), 0xFFFF);
+    std::fill(maxValue.begin(), maxValue.end(), 0);
+    std::fill(maxTime.begin(), maxTime.end(), 0);
+    batchCount = 0;
+    totalCount = 0;
+    epochMs = 0;
+}
+
+void PixelStatsAccumulator::add(const uint16_t *y16, int64_t timeMs) {
+    if (frameCount() == 0) epochMs = timeMs;
+    // Milliseconds since the first frame; saturates after 49 days
+    int64_t elapsed = std::min<int64_t>(std::max<int64_t>(timeMs - epochMs, 0), 0xFFFFFFFFll);
+    const uint32_t now = (uint32_t) elapsed;
+
+    ++batchCount;
+    const float inv = 1.0f / (float) batchCount;
+    const int count = width * height;
+    float *bm = batchMean.data();
+    float *bm2 = batchM2.data();
+    uint16_t *mn = minValue.data();
+    uint16_t *mx = maxValue.data();
+    uint32_t *mt = maxTime.data();
+    int i = 0;
+
+#if PS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i flip = _mm_set1_epi16((short) 0x8000);
+    const __m128i nowV = _mm_set1_epi32((int) now);
+    const __m128 invV = _mm_set1_ps(inv);
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (y16 + i));
+
+        // Welford: delta = x - mean; mean += delta / n; M2 += delta * (x - mean)
+        for (int h = 0; h < 2; ++h) {
+            __m128 x = _mm_cvtepi32_ps(h ? _mm_unpackhi_epi16(v, zero) : _mm_unpacklo_epi16(v, zero));
+            __m128 m = _mm_loadu_ps(bm + i + 4 * h);
+            __m128 delta = _mm_sub_ps(x, m);
+            m = _mm_add_ps(m, _mm_mul_ps(delta, invV));
+            __m128 q = _mm_add_ps(_mm_loadu_ps(bm2 + i + 4 * h), _mm_mul_ps(delta, _mm_sub_ps(x, m)));
+            _mm_storeu_ps(bm + i + 4 * h, m);
+            _mm_storeu_ps(bm2 + i + 4 * h, q);
+        }
+
+        // Unsigned 16-bit min/max through the signed compares
+        __m128i sv = _mm_xor_si128(v, flip);
+        __m128i smin = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (mn + i)), flip);
+        __m128i smax = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (mx + i)), flip);
+        __m128i above = _mm_cmpgt_epi16(sv, smax);
+        _mm_storeu_si128((__m128i *) (mn + i), _mm_xor_si128(_mm_min_epi16(sv, smin), flip));
+        _mm_storeu_si128((__m128i *) (mx + i), _mm_xor_si128(_mm_max_epi16(sv, smax), flip));
+
+        // New maxima take the current time
+        for (int h = 0; h < 2; ++h) {
+            __m128i sel = h ? _mm_unpackhi_epi16(above, above) : _mm_unpacklo_epi16(above, above);
+            __m128i t = _mm_loadu_si128((const __m128i *) (mt + i + 4 * h));
+            t = _mm_or_si128(_mm_and_si128(sel, nowV), _mm_andnot_si128(sel, t));
+            _mm_storeu_si128((__m128i *) (mt + i + 4 * h), t);
+        }
+    }
+#elif PS_NEON
+    const uint32x4_t nowV = vdupq_n_u32(now);
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t v = vld1q_u16(y16 + i);
+        uint16x8_t oldMax = vld1q_u16(mx + i);
+        uint16x8_t above = vcgtq_u16(v, oldMax);
+        vst1q_u16(mn + i, vminq_u16(v, vld1q_u16(mn + i)));
+        vst1q_u16(mx + i, vmaxq_u16(v, oldMax));
+
+        for (int h = 0; h < 2; ++h) {
+            float32x4_t x = vcvtq_f32_u32(vmovl_u16(h ? vget_high_u16(v) : vget_low_u16(v)));
+            float32x4_t m = vld1q_f32(bm + i + 4 * h);
+            float32x4_t delta = vsubq_f32(x, m);
+            m = vaddq_f32(m, vmulq_n_f32(delta, inv));
+            float32x4_t q = vaddq_f32(vld1q_f32(bm2 + i + 4 * h), vmulq_f32(delta, vsubq_f32(x, m)));
+            vst1q_f32(bm + i + 4 * h, m);
+            vst1q_f32(bm2 + i + 4 * h, q);
+
+            uint32x4_t sel = vmovl_u16(h ? vget_high_u16(above) : vget_low_u16(above));
+            sel = vorrq_u32(sel, vshlq_n_u32(sel, 16));
+            vst1q_u32(mt + i + 4 * h, vbslq_u32(sel, nowV, vld1q_u32(mt + i + 4 * h)));
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        float x = (float) y16[i];
+        float delta = x - bm[i];
+        bm[i] += delta * inv;
+        bm2[i] += delta * (x - bm[i]);
+        mn[i] = std::min(mn[i], y16[i]);
+        if (y16[i] > mx[i]) {
+            mx[i] = y16[i];
+            mt[i] = now;
+        }
+    }
+
+    if (batchCount >= BatchFrames) mergeBatch();
+}
+
+void PixelStatsAccumulator::mergeBatch() {
+    if (batchCount == 0) return;
+    // Chan et al. combination of two partial Welford results
+    const double nA = (double) totalCount;
+    const double nB = (double) batchCount;
+    const double n = nA + nB;
+    const size_t count = mean.size();
+    for (size_t i = 0; i < count; ++i) {
+        double delta = (double) batchMean[i] - mean[i];
+        mean[i] += delta * nB / n;
+        m2[i] += (double) batchM2[i] + delta * delta * nA * nB / n;
+    }
+    totalCount += (uint64_t) batchCount;
+    batchCount = 0;
+    std::fill(batchMean.begin(), batchMean.end(), 0.0f);
+    std::fill(batchM2.begin(), batchM2.end(), 0.0f);
+}
+
+void PixelStatsAccumulator::combined(size_t i, double &outMean, double &outVariance) const {
+    const double nA = (double) totalCount;
+    const double nB = (double) batchCount;
+    const double n = nA + nB;
+    if (n <= 0.0) {
+        outMean = 0.0;
+        outVariance = 0.0;
+        return;
+    }
+    double delta = (double) batchMean[i] - mean[i];
+    outMean = mean[i] + delta * nB / n;
+    double total = m2[i] + (double) batchM2[i] + delta * delta * nA * nB / n;
+    outVariance = n > 1.0 ? std::max(total / (n - 1.0), 0.0) : 0.0;
+}
+
+void PixelStatsAccumulator::query(Statistic statistic, float *out) const {
+    const size_t count = mean.size();
+    if (frameCount() == 0) {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        double m, var;
+        switch (statistic) {
+            case Statistic::Mean:
+                combined(i, m, var);
+                out[i] = (float) m;
+                break;
+            case Statistic::StdDev:
+                combined(i, m, var);
+                out[i] = (float) std::sqrt(var);
+                break;
+            case Statistic::Min:
+                out[i] = minValue[i];
+                break;
+            case Statistic::Max:
+                out[i] = maxValue[i];
+                break;
+            case Statistic::Range:
+                out[i] = (float) (maxValue[i] - minValue[i]);
+                break;
+            case Statistic::TimeOfMax:
+                out[i] = (float) maxTime[i] * 0.001f;
+                break;
+        }
+    }
+}
+
+void PixelStatsAccumulator::heatmap(Statistic statistic, uint8_t *gray) const {
+    const size_t count = mean.size();
+    std::vector<float> &values = heatmapValues;
+    values.resize(count);
+    query(statistic, values.data());
+    auto range = std::minmax_element(values.begin(), values.end());
+    float lo = *range.first;
+    float scale = *range.second > lo ? 255.0f / (*range.second - lo) : 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        gray[i] = (uint8_t) std::lround((values[i] - lo) * scale);
+    }
+}
+
+bool PixelStatsAccumulator::openSnapshot(const std::string &path) {
+    closeSnapshot();
+    reset();
+    if (path.empty()) return false;
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    const size_t count = mean.size();
+    const size_t size = snapshotSize(count);
+    struct stat st;
+    bool resume = fstat(fd, &st) == 0 && (size_t) st.st_size == size;
+    if (!resume && ftruncate(fd, (off_t) size) != 0) {
+        close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+    mapping = map;
+    mappingSize = size;
+
+    const auto *header = (const SnapshotHeader *) mapping;
+    resume = resume && std::memcmp(header->magic, SnapshotMagic, 4) == 0 && header->version == SnapshotVersion &&
+             header->width == (uint32_t) width && header->height == (uint32_t) height;
+    if (resume) {
+        const uint8_t *p = (const uint8_t *) mapping + sizeof(SnapshotHeader);
+        std::memcpy(mean.data(), p, count * sizeof(double));
+        p += count * sizeof(double);
+        std::memcpy(m2.data(), p, count * sizeof(double));
+        p += count * sizeof(double);
+        std::memcpy(maxTime.data(), p, count * sizeof(uint32_t));
+        p += count * sizeof(uint32_t);
+        std::memcpy(minValue.data(), p, count * sizeof(uint16_t));
+        p += count * sizeof(uint16_t);
+        std::memcpy(maxValue.data(), p, count * sizeof(uint16_t));
+        totalCount = header->count;
+        epochMs = header->epochMs;
+    }
+    return snapshot();
+}
+
+bool PixelStatsAccumulator::snapshot() {
+    if (!mapping) return false;
+    mergeBatch();
+
+    const size_t count = mean.size();
+    auto *header = (SnapshotHeader *) mapping;
+    std::memcpy(header->magic, SnapshotMagic, 4);
+    header->width = (uint32_t) width;
+    header->height = (uint32_t) height;
+    header->version = SnapshotVersion;
+    header->count = totalCount;
+    header->epochMs = epochMs;
+
+    uint8_t *p = (uint8_t *) mapping + sizeof(SnapshotHeader);
+    std::memcpy(p, mean.data(), count * sizeof(double));
+    p += count * sizeof(double);
+    std::memcpy(p, m2.data(), count * sizeof(double));
+    p += count * sizeof(double);
+    std::memcpy(p, maxTime.data(), count * sizeof(uint32_t));
+    p += count * sizeof(uint32_t);
+    std::memcpy(p, minValue.data(), count * sizeof(uint16_t));
+    p += count * sizeof(uint16_t);
+    std::memcpy(p, maxValue.data(), count * sizeof(uint16_t));
+    return msync(mapping, mappingSize, MS_ASYNC) == 0;
+}
+
+void PixelStatsAccumulator::closeSnapshot() {
+    if (!mapping) return;
+    snapshot();
+    munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+}
@@ -0,0 +1,80 @@
+#ifndef PIXEL_STATS_ACCUMULATOR_HPP
+#define PIXEL_STATS_ACCUMULATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Long-term per-pixel statistics of the Y16 plane: mean, variance, min, max and when the max
+// was reached. Frames are folded in with Welford's update into a short single-precision batch
+// (SIMD over structure-of-arrays planes), and every batch is merged into double-precision
+// totals, so precision holds over days of frames while memory stays fixed at the plane size.
+// The totals can be mirrored into a memory-mapped snapshot file that other tools can read and
+// that a later session resumes from.
+class PixelStatsAccumulator {
+public:
+    enum class Statistic {
+        Mean,
+        StdDev,
+        Min,
+        Max,
+        Range,
+        TimeOfMax // seconds since the first frame
+    };
+
+    static const int BatchFrames = 256;
+
+    PixelStatsAccumulator(int width, int height);
+    ~PixelStatsAccumulator();
+
+    PixelStatsAccumulator(const PixelStatsAccumulator &) = delete;
+    PixelStatsAccumulator &operator=(const PixelStatsAccumulator &) = delete;
+
+    // timeMs is wall-clock time in milliseconds since the Unix epoch
+    void add(const uint16_t *y16, int64_t timeMs);
+    void reset();
+
+    uint64_t frameCount() const { return totalCount + batchCount; }
+    int64_t startTimeMs() const { return epochMs; }
+
+    // One value per pixel in raw counts (seconds for TimeOfMax)
+    void query(Statistic statistic, float *out) const;
+
+    // The statistic stretched over its own range to 8-bit levels for colorizing
+    void heatmap(Statistic statistic, uint8_t *gray) const;
+
+    // Starts over and maps the snapshot file, resuming from it when it holds statistics for the
+    // same plane size
+    bool openSnapshot(const std::string &path);
+    // Writes the current totals into the mapping; the kernel flushes it to disk asynchronously
+    bool snapshot();
+    void closeSnapshot();
+
+private:
+    int width;
+    int height;
+
+    // Current batch
+    std::vector<float> batchMean;
+    std::vector<float> batchM2;
+    int batchCount = 0;
+
+    // Merged totals
+    std::vector<double> mean;
+    std::vector<double> m2;
+    uint64_t totalCount = 0;
+
+    std::vector<uint16_t> minValue;
+    std::vector<uint16_t> maxValue;
+    std::vector<uint32_t> maxTime; // ms after epochMs
+    int64_t epochMs = 0;
+    mutable std::vector<float> heatmapValues;
+
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+
+    void mergeBatch();
+    void combined(size_t i, double &outMean, double &outVariance) const;
+};
+
+#endif
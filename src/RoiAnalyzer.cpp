@@ -0,0 +1,254 @@
+#include "RoiAnalyzer.hpp"
+#include "ThermalCalibration.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+
+RoiAnalyzer::RoiAnalyzer(int width, int height) : width(width), height(height) {
+    levels = 1;
+    while ((2 << (levels - 1)) <= width) levels++;
+
+    sat.assign((size_t) (width + 1) * (height + 1), 0);
+    satSq.assign((size_t) (width + 1) * (height + 1), 0);
+    minTable.resize((size_t) levels * width * height);
+    maxTable.resize((size_t) levels * width * height);
+
+    log2Table.resize(width + 1);
+    log2Table[0] = 0;
+    for (int n = 1; n <= width; ++n) {
+        log2Table[n] = (uint8_t) (n == 1 ? 0 : log2Table[n / 2] + 1);
+    }
+}
+
+RoiAnalyzer::~RoiAnalyzer() {
+    closeLog();
+}
+
+int RoiAnalyzer::add(Roi roi) {
+    roi.id = nextId++;
+    rasterize(roi);
+    regions.push_back(std::move(roi));
+    stats.push_back(valid ? measure(regions.back()) : RoiStats());
+    return regions.back().id;
+}
+
+int RoiAnalyzer::addRectangle(RoiPoint a, RoiPoint b) {
+    Roi roi;
+    roi.shape = Roi::Shape::Rectangle;
+    roi.points = {a, b};
+    return add(std::move(roi));
+}
+
+int RoiAnalyzer::addEllipse(RoiPoint a, RoiPoint b) {
+    Roi roi;
+    roi.shape = Roi::Shape::Ellipse;
+    roi.points = {a, b};
+    return add(std::move(roi));
+}
+
+int RoiAnalyzer::addPolygon(const std::vector<RoiPoint> &vertices) {
+    if (vertices.size() < 3) return -1;
+    Roi roi;
+    roi.shape = Roi::Shape::Polygon;
+    roi.points = vertices;
+    return add(std::move(roi));
+}
+
+void RoiAnalyzer::clear() {
+    regions.clear();
+    stats.clear();
+}
+
+void RoiAnalyzer::rasterize(Roi &roi) const {
+    roi.spans.clear();
+    auto addSpan = [&](int y, int x0, int x1) {
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, width - 1);
+        if (y >= 0 && y < height && x0 <= x1) roi.spans.push_back({y, x0, x1});
+    };
+
+    if (roi.shape == Roi::Shape::Rectangle || roi.shape == Roi::Shape::Ellipse) {
+        float minX = std::min(roi.points[0].x, roi.points[1].x), maxX = std::max(roi.points[0].x, roi.points[1].x);
+        float minY = std::min(roi.points[0].y, roi.points[1].y), maxY = std::max(roi.points[0].y, roi.points[1].y);
+
+        if (roi.shape == Roi::Shape::Rectangle) {
+            int x0 = (int) std::lround(minX), x1 = (int) std::lround(maxX);
+            for (int y = (int) std::lround(minY); y <= (int) std::lround(maxY); ++y) addSpan(y, x0, x1);
+        } else {
+            float cx = (minX + maxX) * 0.5f, cy = (minY + maxY) * 0.5f;
+            float rx = std::max((maxX - minX) * 0.5f, 0.5f), ry = std::max((maxY - minY) * 0.5f, 0.5f);
+            for (int y = (int) std::ceil(cy - ry); y <= (int) std::floor(cy + ry); ++y) {
+                float dy = (y - cy) / ry;
+                float half = rx * std::sqrt(std::max(1.0f - dy * dy, 0.0f));
+                addSpan(y, (int) std::ceil(cx - half), (int) std::floor(cx + half));
+            }
+        }
+        return;
+    }
+
+    // Polygon: even-odd scanline fill through the pixel centres
+    const auto &p = roi.points;
+    float minY = p[0].y, maxY = p[0].y;
+    for (const auto &v: p) {
+        minY = std::min(minY, v.y);
+        maxY = std::max(maxY, v.y);
+    }
+    std::vector<float> crossings;
+    for (int y = (int) std::ceil(minY); y <= (int) std::floor(maxY); ++y) {
+        crossings.clear();
+        for (size_t i = 0, j = p.size() - 1; i < p.size(); j = i++) {
+            const RoiPoint &a = p[i], &b = p[j];
+            if ((a.y <= y && b.y > y) || (b.y <= y && a.y > y)) {
+                crossings.push_back(a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+            addSpan(y, (int) std::ceil(crossings[i]), (int) std::floor(crossings[i + 1]));
+        }
+    }
+}
+
+void RoiAnalyzer::update(const uint16_t *y16, ThreadPool *pool) {
+    const int stride = width + 1;
+    const size_t plane = (size_t) width * height;
+
+    // Per row: prefix sums into the table rows and the min/max doubling levels
+    forEachBand(pool, height, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            const uint16_t *row = y16 + (size_t) y * width;
+            uint64_t *s = &sat[(size_t) (y + 1) * stride];
+            uint64_t *q = &satSq[(size_t) (y + 1) * stride];
+            uint64_t acc = 0, accSq = 0;
+            s[0] = 0;
+            q[0] = 0;
+            for (int x = 0; x < width; ++x) {
+                uint32_t v = row[x];
+                acc += v;
+                accSq += (uint64_t) v * v;
+                s[x + 1] = acc;
+                q[x + 1] = accSq;
+            }
+
+            std::copy(row, row + width, &minTable[(size_t) y * width]);
+            std::copy(row, row + width, &maxTable[(size_t) y * width]);
+            for (int k = 1; k < levels; ++k) {
+                const int half = 1 << (k - 1);
+                const uint16_t *pmin = &minTable[(k - 1) * plane + (size_t) y * width];
+                const uint16_t *pmax = &maxTable[(k - 1) * plane + (size_t) y * width];
+                uint16_t *cmin = &minTable[k * plane + (size_t) y * width];
+                uint16_t *cmax = &maxTable[k * plane + (size_t) y * width];
+                for (int x = 0; x + (1 << k) <= width; ++x) {
+                    cmin[x] = std::min(pmin[x], pmin[x + half]);
+                    cmax[x] = std::max(pmax[x], pmax[x + half]);
+                }
+            }
+        }
+    });
+
+    // Accumulate the row prefixes down the columns
+    for (int y = 1; y <= height; ++y) {
+        uint64_t *s = &sat[(size_t) y * stride];
+        uint64_t *q = &satSq[(size_t) y * stride];
+        const uint64_t *ps = s - stride;
+        const uint64_t *pq = q - stride;
+        for (int x = 1; x <= width; ++x) {
+            s[x] += ps[x];
+            q[x] += pq[x];
+        }
+    }
+    valid = true;
+
+    for (size_t i = 0; i < regions.size(); ++i) {
+        stats[i] = measure(regions[i]);
+    }
+}
+
+uint64_t RoiAnalyzer::rectSum(const std::vector<uint64_t> &table, int x0, int y0, int x1, int y1) const {
+    const int stride = width + 1;
+    return table[(size_t) (y1 + 1) * stride + x1 + 1] - table[(size_t) y0 * stride + x1 + 1]
+           - table[(size_t) (y1 + 1) * stride + x0] + table[(size_t) y0 * stride + x0];
+}
+
+void RoiAnalyzer::spanMinMax(int y, int x0, int x1, uint16_t &lo, uint16_t &hi) const {
+    // Two overlapping power-of-two windows cover the span
+    const size_t plane = (size_t) width * height;
+    int k = log2Table[x1 - x0 + 1];
+    size_t base = k * plane + (size_t) y * width;
+    size_t second = base + x1 - (1 << k) + 1;
+    lo = std::min(lo, std::min(minTable[base + x0], minTable[second]));
+    hi = std::max(hi, std::max(maxTable[base + x0], maxTable[second]));
+}
+
+RoiStats RoiAnalyzer::finish(int count, uint64_t sum, uint64_t sumSq, uint16_t lo, uint16_t hi) {
+    RoiStats r;
+    if (count == 0) return r;
+    r.count = count;
+    r.min = lo;
+    r.max = hi;
+    r.mean = (double) sum / count;
+    r.stddev = std::sqrt(std::max((double) sumSq / count - r.mean * r.mean, 0.0));
+    return r;
+}
+
+RoiStats RoiAnalyzer::measureRect(int x0, int y0, int x1, int y1) const {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width - 1);
+    y1 = std::min(y1, height - 1);
+    if (!valid || x0 > x1 || y0 > y1) return RoiStats();
+
+    uint16_t lo = 0xFFFF, hi = 0;
+    for (int y = y0; y <= y1; ++y) spanMinMax(y, x0, x1, lo, hi);
+    int count = (x1 - x0 + 1) * (y1 - y0 + 1);
+    return finish(count, rectSum(sat, x0, y0, x1, y1), rectSum(satSq, x0, y0, x1, y1), lo, hi);
+}
+
+RoiStats RoiAnalyzer::measure(const Roi &roi) const {
+    if (!valid || roi.spans.empty()) return RoiStats();
+    if (roi.shape == Roi::Shape::Rectangle) {
+        const Roi::Span &first = roi.spans.front();
+        return measureRect(first.x0, first.y, first.x1, roi.spans.back().y);
+    }
+
+    int count = 0;
+    uint64_t sum = 0, sumSq = 0;
+    uint16_t lo = 0xFFFF, hi = 0;
+    for (const Roi::Span &s: roi.spans) {
+        count += s.x1 - s.x0 + 1;
+        sum += rectSum(sat, s.x0, s.y, s.x1, s.y);
+        sumSq += rectSum(satSq, s.x0, s.y, s.x1, s.y);
+        spanMinMax(s.y, s.x0, s.x1, lo, hi);
+    }
+    return finish(count, sum, sumSq, lo, hi);
+}
+
+bool RoiAnalyzer::openLog(const std::string &path) {
+    closeLog();
+    logFile = std::fopen(path.c_str(), "w");
+    if (!logFile) return false;
+    std::fprintf(logFile, "seconds,roi,shape,pixels,min,max,mean,stddev,unit\n");
+    return true;
+}
+
+void RoiAnalyzer::logFrame(double seconds, const ThermalCalibration &calibration) {
+    if (!logFile) return;
+    static const char *shapeNames[] = {"rectangle", "ellipse", "polygon"};
+    for (size_t i = 0; i < regions.size(); ++i) {
+        const RoiStats &s = stats[i];
+        if (s.count == 0) continue;
+        double mean = calibration.toTemperatureInterpolated((float) s.mean);
+        // Local slope of the conversion turns the raw deviation into a temperature deviation
+        double slope = calibration.toTemperatureInterpolated((float) s.mean + 1.0f) - mean;
+        std::fprintf(logFile, "%.3f,%d,%s,%d,%.2f,%.2f,%.2f,%.3f,%s\n", seconds, regions[i].id,
+                     shapeNames[(int) regions[i].shape], s.count, calibration.toTemperature(s.min),
+                     calibration.toTemperature(s.max), mean, s.stddev * slope, calibration.unitSuffix());
+    }
+}
+
+void RoiAnalyzer::closeLog() {
+    if (logFile) {
+        std::fclose(logFile);
+        logFile = nullptr;
+    }
+}
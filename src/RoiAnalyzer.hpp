@@ -0,0 +1,93 @@
+#ifndef ROI_ANALYZER_HPP
+#define ROI_ANALYZER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+class ThermalCalibration;
+
+struct RoiPoint {
+    float x, y; // sensor coordinates, pixel centres at integers
+};
+
+struct Roi {
+    enum class Shape {
+        Rectangle,
+        Ellipse,
+        Polygon
+    };
+
+    struct Span {
+        int y, x0, x1; // inclusive
+    };
+
+    int id = 0;
+    Shape shape = Shape::Rectangle;
+    std::vector<RoiPoint> points; // Rectangle/Ellipse: two opposite corners; Polygon: vertices
+    std::vector<Span> spans;      // rasterized once when the region is added
+};
+
+struct RoiStats {
+    int count = 0;
+    uint16_t min = 0;
+    uint16_t max = 0;
+    double mean = 0.0;   // raw Y16
+    double stddev = 0.0; // raw Y16
+};
+
+// Measures any number of regions on a Y16 frame. update() builds summed-area tables of the
+// values and their squares plus per-row sparse min/max tables once per frame; afterwards each
+// region costs one table lookup per row (rectangle sums a single lookup) regardless of its area.
+class RoiAnalyzer {
+public:
+    RoiAnalyzer(int width, int height);
+    ~RoiAnalyzer();
+
+    int addRectangle(RoiPoint a, RoiPoint b);
+    int addEllipse(RoiPoint a, RoiPoint b); // bounding box corners
+    int addPolygon(const std::vector<RoiPoint> &vertices);
+    void clear();
+
+    const std::vector<Roi> &rois() const { return regions; }
+    const std::vector<RoiStats> &results() const { return stats; } // parallel to rois()
+
+    // Rebuilds the tables for a new frame and measures every region
+    void update(const uint16_t *y16, ThreadPool *pool = nullptr);
+
+    // Queries against the tables of the last update()
+    RoiStats measureRect(int x0, int y0, int x1, int y1) const; // inclusive
+    RoiStats measure(const Roi &roi) const;
+
+    // CSV log of every region's statistics, one row per region and frame
+    bool openLog(const std::string &path);
+    void logFrame(double seconds, const ThermalCalibration &calibration);
+    void closeLog();
+
+private:
+    int width;
+    int height;
+    int levels;
+    std::vector<Roi> regions;
+    std::vector<RoiStats> stats;
+    int nextId = 1;
+
+    std::vector<uint64_t> sat;   // (width + 1) x (height + 1), row 0 and column 0 are zero
+    std::vector<uint64_t> satSq;
+    std::vector<uint16_t> minTable; // levels x height x width, level k covers 2^k pixels
+    std::vector<uint16_t> maxTable;
+    std::vector<uint8_t> log2Table;
+    bool valid = false;
+
+    std::FILE *logFile = nullptr;
+
+    int add(Roi roi);
+    void rasterize(Roi &roi) const;
+    void spanMinMax(int y, int x0, int x1, uint16_t &lo, uint16_t &hi) const;
+    uint64_t rectSum(const std::vector<uint64_t> &table, int x0, int y0, int x1, int y1) const;
+    static RoiStats finish(int count, uint64_t sum, uint64_t sumSq, uint16_t lo, uint16_t hi);
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "TemporalFilter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TF_NEON 1
+#define TF_SSE2 0
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TF_NEON 0
+#define TF_SSE2 1
+#else
+#define TF_NEON 0
+#define TF_SSE2 0
+#endif
+
+TemporalFilter::TemporalFilter(int width, int height) : width(width), height(height), state((size_t) width * height) {
+    setParams(params);
+}
+
+void TemporalFilter::setParams(const Params &p) {
+    params = p;
+    float strength = std::min(std::max(params.strength, 0.0f), 0.97f);
+    minWeight = (int32_t) std::lround(256.0f * (1.0f - strength));
+    int threshold = std::max(params.motionThreshold, 1);
+    weightSlope = (256 - minWeight + threshold - 1) / threshold;
+}
+
+double TemporalFilter::sampleMean(const uint16_t *y16) const {
+    // Every 8th row is plenty to notice a global jump
+    uint64_t sum = 0;
+    int count = 0;
+    for (int y = 0; y < height; y += 8) {
+        const uint16_t *row = y16 + (size_t) y * width;
+        for (int x = 0; x < width; ++x) sum += row[x];
+        count += width;
+    }
+    return count ? (double) sum / count : 0.0;
+}
+
+#if TF_SSE2
+// SSE2 has no 32-bit low multiply; the low halves of two unsigned 32x32 products are the same
+static inline __m128i mullo32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i min32(__m128i a, __m128i b) {
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+}
+
+// One step for 4 pixels: state += (cur - state) * weight(|cur - state|) >> 8
+static inline __m128i step(__m128i s, __m128i cur, __m128i minW, __m128i slope) {
+    const __m128i full = _mm_set1_epi32(256);
+    __m128i d = _mm_sub_epi32(_mm_slli_epi32(cur, 4), s);
+    __m128i sign = _mm_srai_epi32(d, 31);
+    __m128i mag = _mm_srli_epi32(_mm_sub_epi32(_mm_xor_si128(d, sign), sign), 4);
+    __m128i w = min32(_mm_add_epi32(minW, mullo32(min32(mag, full), slope)), full);
+    return _mm_add_epi32(s, _mm_srai_epi32(mullo32(d, w), 8));
+}
+#endif
+
+void TemporalFilter::process(uint16_t *y16) {
+    const int count = width * height;
+    double mean = sampleMean(y16);
+    bool jump = std::fabs(mean - lastMean) > params.resetThreshold;
+    lastMean = mean;
+
+    if (!primed || jump || params.strength <= 0.0f) {
+        for (int i = 0; i < count; ++i) state[i] = (int32_t) y16[i] << 4;
+        primed = true;
+        return;
+    }
+
+    int32_t *s = state.data();
+    int i = 0;
+
+#if TF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i minW = _mm_set1_epi32(minWeight);
+    const __m128i slope = _mm_set1_epi32(weightSlope);
+    const __m128i round = _mm_set1_epi32(8);
+    for (; i + 8 <= count; i += 8) {
+        __m128i cur = _mm_loadu_si128((const __m128i *) (y16 + i));
+        __m128i s0 = step(_mm_loadu_si128((const __m128i *) (s + i)), _mm_unpacklo_epi16(cur, zero), minW, slope);
+        __m128i s1 = step(_mm_loadu_si128((const __m128i *) (s + i + 4)), _mm_unpackhi_epi16(cur, zero), minW, slope);
+        _mm_storeu_si128((__m128i *) (s + i), s0);
+        _mm_storeu_si128((__m128i *) (s + i + 4), s1);
+
+        // Back to counts; values stay within 0..65535 so the biased signed pack is exact
+        __m128i bias = _mm_set1_epi32(32768);
+        __m128i o0 = _mm_sub_epi32(_mm_srai_epi32(_mm_add_epi32(s0, round), 4), bias);
+        __m128i o1 = _mm_sub_epi32(_mm_srai_epi32(_mm_add_epi32(s1, round), 4), bias);
+        __m128i out = _mm_xor_si128(_mm_packs_epi32(o0, o1), _mm_set1_epi16((short) 0x8000));
+        _mm_storeu_si128((__m128i *) (y16 + i), out);
+    }
+#elif TF_NEON
+    const int32x4_t minW = vdupq_n_s32(minWeight);
+    const int32x4_t slope = vdupq_n_s32(weightSlope);
+    const int32x4_t full = vdupq_n_s32(256);
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t cur = vld1q_u16(y16 + i);
+        int32x4_t c[2] = {vreinterpretq_s32_u32(vshll_n_u16(vget_low_u16(cur), 4)),
+                          vreinterpretq_s32_u32(vshll_n_u16(vget_high_u16(cur), 4))};
+        uint16x4_t out[2];
+        for (int h = 0; h < 2; ++h) {
+            int32x4_t sv = vld1q_s32(s + i + 4 * h);
+            int32x4_t d = vsubq_s32(c[h], sv);
+            int32x4_t mag = vminq_s32(vshrq_n_s32(vabsq_s32(d), 4), full);
+            int32x4_t w = vminq_s32(vmlaq_s32(minW, mag, slope), full);
+            sv = vaddq_s32(sv, vshrq_n_s32(vmulq_s32(d, w), 8));
+            vst1q_s32(s + i + 4 * h, sv);
+            out[h] = vqrshrun_n_s32(sv, 4);
+        }
+        vst1q_u16(y16 + i, vcombine_u16(out[0], out[1]));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        int32_t d = ((int32_t) y16[i] << 4) - s[i];
+        int32_t mag = std::min(std::abs(d) >> 4, 256);
+        int32_t w = std::min(minWeight + mag * weightSlope, 256);
+        s[i] += (d * w) >> 8;
+        y16[i] = (uint16_t) ((s[i] + 8) >> 4);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef TEMPORAL_FILTER_HPP
+#define TEMPORAL_FILTER_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Motion-adaptive recursive filter for the Y16 plane. Each pixel blends towards the new frame
+// with a weight that grows with the frame-to-frame difference: static noise is averaged
+// strongly while real changes (motion, heating) pass through within a frame or two.
+// The state is kept in 1/16 counts so small weights do not stall on rounding. A jump of the
+// global mean (NUC/shutter) resets the state to the new frame.
+class TemporalFilter {
+public:
+    struct Params {
+        float strength = 0.75f;   // 0 = off, towards 1 = stronger averaging of static pixels
+        int motionThreshold = 48; // differences of this many counts (0.75 K) pass unfiltered
+        int resetThreshold = 64;  // global mean jump in counts treated as a NUC/shutter event
+    };
+
+    TemporalFilter(int width, int height);
+
+    void setParams(const Params &p);
+    const Params &getParams() const { return params; }
+
+    // Filters the plane in place
+    void process(uint16_t *y16);
+    void reset() { primed = false; }
+
+private:
+    int width;
+    int height;
+    Params params;
+    std::vector<int32_t> state; // Q4
+    bool primed = false;
+    double lastMean = 0.0;
+    int32_t minWeight = 64;  // Q8 weight of the new frame for static pixels
+    int32_t weightSlope = 0; // Q8 weight increase per count of difference
+
+    double sampleMean(const uint16_t *y16) const;
+};
+
+#endif
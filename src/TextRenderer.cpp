@@ -0,0 +1,143 @@
+#include "TextRenderer.hpp"
+#include <algorithm>
+
+TextRenderer::~TextRenderer() {
+    release();
+}
+
+void TextRenderer::release() {
+    if (atlas) SDL_DestroyTexture(atlas);
+    atlas = nullptr;
+    for (CachedText &c: cache) SDL_DestroyTexture(c.texture);
+    cache.clear();
+}
+
+bool TextRenderer::init(SDL_Renderer *r, TTF_Font *f) {
+    release();
+    renderer = r;
+    font = f;
+    if (!renderer || !font) return false;
+
+    height = TTF_FontHeight(font);
+    const int glyphCount = LastGlyph - FirstGlyph + 1;
+
+    // Render each glyph once, then shelf-pack them into rows of a fixed-width atlas
+    SDL_Color white = {255, 255, 255, 255};
+    std::vector<SDL_Surface *> surfaces(glyphCount, nullptr);
+    const int rowWidth = 512;
+    int x = 0, y = 0;
+    for (int i = 0; i < glyphCount; ++i) {
+        Glyph &g = glyphs[i];
+        int minX, maxX, minY, maxY;
+        if (TTF_GlyphMetrics(font, (Uint16) (FirstGlyph + i), &minX, &maxX, &minY, &maxY, &g.advance) != 0) {
+            g.advance = 0;
+        }
+        surfaces[i] = TTF_RenderGlyph_Blended(font, (Uint16) (FirstGlyph + i), white);
+        if (!surfaces[i]) continue;
+        if (x + surfaces[i]->w > rowWidth) {
+            x = 0;
+            y += height + 1;
+        }
+        g.source = {x, y, surfaces[i]->w, surfaces[i]->h};
+        x += surfaces[i]->w + 1;
+    }
+    atlasWidth = rowWidth;
+    atlasHeight = y + height + 1;
+
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (sheet) {
+        for (int i = 0; i < glyphCount; ++i) {
+            if (!surfaces[i]) continue;
+            // Copy coverage as is instead of blending it onto the empty sheet
+            SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+            SDL_Rect dest = glyphs[i].source;
+            SDL_BlitSurface(surfaces[i], nullptr, sheet, &dest);
+        }
+        atlas = SDL_CreateTextureFromSurface(renderer, sheet);
+        SDL_FreeSurface(sheet);
+    }
+    for (SDL_Surface *s: surfaces) {
+        if (s) SDL_FreeSurface(s);
+    }
+    if (!atlas) return false;
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+SDL_Point TextRenderer::measure(const char *text) const {
+    int w = 0;
+    for (const char *c = text; *c; ++c) {
+        int index = (unsigned char) *c - FirstGlyph;
+        if (index >= 0 && index <= LastGlyph - FirstGlyph) w += glyphs[index].advance;
+    }
+    return SDL_Point{w, height};
+}
+
+void TextRenderer::draw(const char *text, int x, int y, SDL_Color color) {
+    if (!atlas) return;
+    immediate.clear();
+    draw(text, x, y, color, immediate);
+    immediate.submit(renderer);
+}
+
+void TextRenderer::draw(const char *text, int x, int y, SDL_Color color, OverlayBatch &batch) const {
+    if (!atlas) return;
+    const float invW = 1.0f / (float) atlasWidth;
+    const float invH = 1.0f / (float) atlasHeight;
+    int pen = x;
+    for (const char *c = text; *c; ++c) {
+        int index = (unsigned char) *c - FirstGlyph;
+        if (index < 0 || index > LastGlyph - FirstGlyph) continue;
+        const Glyph &g = glyphs[index];
+        if (g.source.w > 0 && *c != ' ') {
+            SDL_FRect dest = {(float) pen, (float) y, (float) g.source.w, (float) g.source.h};
+            SDL_FRect source = {g.source.x * invW, g.source.y * invH, g.source.w * invW, g.source.h * invH};
+            batch.texturedQuad(atlas, dest, source, color);
+        }
+        pen += g.advance;
+    }
+}
+
+SDL_Point TextRenderer::drawCached(const std::string &text, int x, int y, SDL_Color color) {
+    if (!renderer || !font || text.empty()) return SDL_Point{0, 0};
+    const uint32_t key = (uint32_t) color.r << 24 | (uint32_t) color.g << 16 | (uint32_t) color.b << 8 | color.a;
+
+    CachedText *entry = nullptr;
+    for (CachedText &c: cache) {
+        if (c.color == key && c.text == text) {
+            entry = &c;
+            break;
+        }
+    }
+
+    if (!entry) {
+        SDL_Surface *surface = TTF_RenderText_Blended(font, text.c_str(), color);
+        if (!surface) return SDL_Point{0, 0};
+        SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+        int w = surface->w, h = surface->h;
+        SDL_FreeSurface(surface);
+        if (!texture) return SDL_Point{0, 0};
+
+        // Replace the least recently used entry once the cache is full
+        if (cache.size() >= MaxCached) {
+            auto oldest = std::min_element(cache.begin(), cache.end(), [](const CachedText &a, const CachedText &b) {
+                return a.lastUse < b.lastUse;
+            });
+            SDL_DestroyTexture(oldest->texture);
+            entry = &*oldest;
+        } else {
+            cache.emplace_back();
+            entry = &cache.back();
+        }
+        entry->text = text;
+        entry->color = key;
+        entry->texture = texture;
+        entry->w = w;
+        entry->h = h;
+    }
+
+    entry->lastUse = ++useCounter;
+    SDL_Rect dest = {x, y, entry->w, entry->h};
+    SDL_RenderCopy(renderer, entry->texture, nullptr, &dest);
+    return SDL_Point{entry->w, entry->h};
+}
@@ -0,0 +1,75 @@
+#ifndef TEXT_RENDERER_HPP
+#define TEXT_RENDERER_HPP
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "OverlayBatch.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Overlay text without rasterizing or uploading anything per frame. Printable ASCII is rendered
+// once into a white glyph atlas; a string becomes one batch of textured quads laid out from the
+// glyph advances and tinted through the vertex colour (SDL_RenderGeometry). Strings that rarely
+// change can instead come from textures cached by content, which keeps the font's kerning.
+class TextRenderer {
+public:
+    TextRenderer() = default;
+    ~TextRenderer();
+
+    TextRenderer(const TextRenderer &) = delete;
+    TextRenderer &operator=(const TextRenderer &) = delete;
+
+    // Builds the atlas; must be called again if the renderer is recreated
+    bool init(SDL_Renderer *renderer, TTF_Font *font);
+    void release();
+    bool ready() const { return atlas != nullptr; }
+
+    int lineHeight() const { return height; }
+
+    // Width and height of the string as draw() lays it out
+    SDL_Point measure(const char *text) const;
+
+    // Draws the string with its top left corner at (x, y)
+    void draw(const char *text, int x, int y, SDL_Color color);
+
+    // Same, appending the glyph quads to a batch submitted later with the rest of the overlay
+    void draw(const char *text, int x, int y, SDL_Color color, OverlayBatch &batch) const;
+
+    // Same from a texture cached by text and colour; returns the drawn size
+    SDL_Point drawCached(const std::string &text, int x, int y, SDL_Color color);
+
+private:
+    struct Glyph {
+        SDL_Rect source = {0, 0, 0, 0};
+        int advance = 0;
+    };
+
+    struct CachedText {
+        std::string text;
+        uint32_t color = 0;
+        SDL_Texture *texture = nullptr;
+        int w = 0;
+        int h = 0;
+        uint64_t lastUse = 0;
+    };
+
+    static const int FirstGlyph = 32;
+    static const int LastGlyph = 126;
+    static const size_t MaxCached = 32;
+
+    SDL_Renderer *renderer = nullptr;
+    TTF_Font *font = nullptr;
+    SDL_Texture *atlas = nullptr;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    int height = 0;
+    Glyph glyphs[LastGlyph - FirstGlyph + 1];
+
+    OverlayBatch immediate;
+
+    std::vector<CachedText> cache;
+    uint64_t useCounter = 0;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "ThermalCalibration.hpp"
+#include <algorithm>
+#include <cmath>
+
+ThermalCalibration::Params ThermalCalibration::Params::fromTpd(uint16_t ems, uint16_t tu, uint16_t ta, uint16_t tau) {
+    Params p;
+    if (ems > 0 && ems <= 127) p.emissivity = ems / 127.0;
+    if (tu > 0 && tu <= 1024) p.reflectedK = tu;
+    if (ta > 0 && ta <= 1024) p.atmosphericK = ta;
+    if (tau > 0 && tau <= 127) p.transmittance = tau / 127.0;
+    return p;
+}
+
+ThermalCalibration::ThermalCalibration() : table(65536) {
+    rebuild();
+}
+
+void ThermalCalibration::setParams(const Params &p) {
+    params = p;
+    rebuild();
+}
+
+void ThermalCalibration::setUnit(TemperatureUnit u) {
+    unit = u;
+    rebuild();
+}
+
+const char *ThermalCalibration::unitSuffix() const {
+    switch (unit) {
+        case TemperatureUnit::Fahrenheit: return "F";
+        case TemperatureUnit::Kelvin: return "K";
+        default: return "C";
+    }
+}
+
+void ThermalCalibration::rebuild() {
+    // Kelvin -> unit is affine: unit = k * K + d
+    double k = 1.0, d = 0.0;
+    if (unit == TemperatureUnit::Celsius) {
+        d = -273.15;
+    } else if (unit == TemperatureUnit::Fahrenheit) {
+        k = 1.8;
+        d = -459.67;
+    }
+
+    const double eps = params.emissivity;
+    const double tau = params.transmittance;
+    affine = (eps >= 1.0 && tau >= 1.0);
+    affineScale = (float) (k / 64.0);
+    affineOffset = (float) d;
+
+    const double refl4 = std::pow(params.reflectedK, 4.0);
+    const double atm4 = std::pow(params.atmosphericK, 4.0);
+    const double background = tau * (1.0 - eps) * refl4 + (1.0 - tau) * atm4;
+    const double gain = 1.0 / (tau * eps);
+
+    for (int raw = 0; raw < 65536; ++raw) {
+        double kelvin = raw / 64.0;
+        if (!affine) {
+            double obj4 = (std::pow(kelvin, 4.0) - background) * gain;
+            kelvin = obj4 > 0.0 ? std::pow(obj4, 0.25) : 0.0;
+        }
+        table[raw] = (int32_t) std::lround((kelvin * k + d) * Scale);
+    }
+}
+
+double ThermalCalibration::toTemperatureInterpolated(float raw) const {
+    float clamped = std::min(std::max(raw, 0.0f), 65535.0f);
+    int lo = (int) clamped;
+    int hi = std::min(lo + 1, 65535);
+    double t = clamped - lo;
+    return (table[lo] + (table[hi] - table[lo]) * t) * (1.0 / Scale);
+}
+
+uint16_t ThermalCalibration::toRaw(double temperature) const {
+    // The table is monotonic, so a binary search gives the inverse
+    int32_t target = (int32_t) std::ceil(temperature * Scale);
+    auto it = std::lower_bound(table.begin(), table.end(), target);
+    if (it == table.end()) return 65535;
+    return (uint16_t) (it - table.begin());
+}
+
+double ThermalCalibration::countsToDelta(uint16_t raw, int counts) const {
+    int upper = std::min(65535, std::max(0, raw + counts));
+    return (table[upper] - table[raw]) * (1.0 / Scale);
+}
+
+void ThermalCalibration::convert(const uint16_t *raw, float *out, int count) const {
+    if (affine) {
+        const float s = affineScale;
+        const float o = affineOffset;
+        for (int i = 0; i < count; ++i) {
+            out[i] = (float) raw[i] * s + o;
+        }
+    } else {
+        const int32_t *lut = table.data();
+        const float inv = 1.0f / Scale;
+        for (int i = 0; i < count; ++i) {
+            out[i] = (float) lut[raw[i]] * inv;
+        }
+    }
+}
+
+void ThermalCalibration::convertRegion(const uint16_t *raw, int rawStride, int x, int y, int w, int h,
+                                       float *out, int outStride) const {
+    for (int row = 0; row < h; ++row) {
+        convert(raw + (size_t) (y + row) * rawStride + x, out + (size_t) row * outStride, w);
+    }
+}
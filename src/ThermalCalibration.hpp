@@ -0,0 +1,73 @@
+#ifndef THERMAL_CALIBRATION_HPP
+#define THERMAL_CALIBRATION_HPP
+
+#include <cstdint>
+#include <vector>
+
+enum class TemperatureUnit {
+    Celsius,
+    Fahrenheit,
+    Kelvin
+};
+
+// Converts raw Y16 values to temperatures through a precomputed table covering all 65536 values.
+// Y16 is 1/64 K of apparent (blackbody equivalent) temperature. Emissivity, reflected and
+// atmospheric temperature and transmittance are applied with a Stefan-Boltzmann model:
+//   T_meas^4 = tau * (eps * T_obj^4 + (1 - eps) * T_refl^4) + (1 - tau) * T_atm^4
+class ThermalCalibration {
+public:
+    struct Params {
+        double emissivity = 1.0;
+        double reflectedK = 293.15;
+        double atmosphericK = 293.15;
+        double transmittance = 1.0;
+
+        // Builds parameters from raw TPD property values (EMS and TAU in 1/127, TU and TA in K).
+        // Out of range values (e.g. from a failed read) fall back to the defaults.
+        static Params fromTpd(uint16_t ems, uint16_t tu, uint16_t ta, uint16_t tau);
+    };
+
+    // Fixed-point scale of the table: temperatures are stored in 1/100 of the unit
+    static constexpr int Scale = 100;
+
+    ThermalCalibration();
+
+    void setParams(const Params &p);
+    const Params &getParams() const { return params; }
+
+    void setUnit(TemperatureUnit u);
+    TemperatureUnit getUnit() const { return unit; }
+    const char *unitSuffix() const; // "C", "F" or "K"
+
+    // Per-pixel readout as a table lookup
+    int32_t toFixed(uint16_t raw) const { return table[raw]; }
+    double toTemperature(uint16_t raw) const { return table[raw] * (1.0 / Scale); }
+
+    // Linear interpolation between table entries for fractional raw values (e.g. fitted peaks)
+    double toTemperatureInterpolated(float raw) const;
+
+    // Inverse lookup: smallest raw value whose temperature is at least the given value
+    uint16_t toRaw(double temperature) const;
+
+    // Temperature difference in the current unit that corresponds to a raw count difference
+    // at the given raw level (for thresholds expressed in counts)
+    double countsToDelta(uint16_t raw, int counts) const;
+
+    // Full-frame or ROI temperature maps. Uncorrected parameters are an affine function of the
+    // raw value and run as a vectorized multiply-add; otherwise each pixel is a table lookup.
+    void convert(const uint16_t *raw, float *out, int count) const;
+    void convertRegion(const uint16_t *raw, int rawStride, int x, int y, int w, int h,
+                       float *out, int outStride) const;
+
+private:
+    Params params;
+    TemperatureUnit unit = TemperatureUnit::Celsius;
+    std::vector<int32_t> table;
+    bool affine = true;
+    float affineScale = 0.0f;
+    float affineOffset = 0.0f;
+
+    void rebuild();
+};
+
+#endif
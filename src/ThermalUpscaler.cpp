@@ -0,0 +1,440 @@
+#include "ThermalUpscaler.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TU_NEON 1
+#define TU_SSE2 0
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TU_NEON 0
+#define TU_SSE2 1
+#else
+#define TU_NEON 0
+#define TU_SSE2 0
+#endif
+
+// The separable methods widen the source rows the region needs to floats with replicated
+// borders, so every output pixel's taps are contiguous and never need clamping. A horizontal
+// pass resamples those rows into a float buffer, then a vertical pass blends whole contiguous
+// rows with the same weights. The horizontal kernels handle four output pixels per step: the
+// bilinear one loads each pixel's sample pair and separates the products with a shuffle, the
+// Lanczos one multiplies each pixel's eight (six plus zero-weighted) samples and transposes the
+// four partial sums. Nearest only gathers and stays scalar.
+
+namespace {
+    float sinc(float x) {
+        if (std::fabs(x) < 1e-5f) return 1.0f;
+        float px = (float) M_PI * x;
+        return std::sin(px) / px;
+    }
+
+#if TU_SSE2
+    // Eight floats to uint16 with saturation, truncating like the scalar conversion. SSE2 only
+    // packs signed 32-bit values, so the range is shifted down by 32768 and back.
+    inline __m128i packClamped(__m128 lo, __m128 hi) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 max = _mm_set1_ps(65535.0f);
+        const __m128i bias = _mm_set1_epi32(32768);
+        __m128i a = _mm_sub_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(lo, zero), max)), bias);
+        __m128i b = _mm_sub_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(hi, zero), max)), bias);
+        return _mm_xor_si128(_mm_packs_epi32(a, b), _mm_set1_epi16((short) 0x8000));
+    }
+
+    inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // Samples first[j] and first[j] + 1 of four pixels, as (s0 s1 s2 s3) and (t0 t1 t2 t3)
+    inline void loadPairs(const float *src, const int *first, __m128 &s, __m128 &t) {
+        __m128 p01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (src + first[0])),
+                                  (const __m64 *) (src + first[1]));
+        __m128 p23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (src + first[2])),
+                                  (const __m64 *) (src + first[3]));
+        s = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+        t = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+#elif TU_NEON
+    inline uint16x8_t packClamped(float32x4_t lo, float32x4_t hi) {
+        // The unsigned conversion truncates and saturates negative values to 0, the narrowing
+        // saturates above 65535
+        return vcombine_u16(vqmovn_u32(vcvtq_u32_f32(lo)), vqmovn_u32(vcvtq_u32_f32(hi)));
+    }
+
+    inline void loadPairs(const float *src, const int *first, float32x4_t &s, float32x4_t &t) {
+        float32x4x2_t p = vuzpq_f32(vcombine_f32(vld1_f32(src + first[0]), vld1_f32(src + first[1])),
+                                    vcombine_f32(vld1_f32(src + first[2]), vld1_f32(src + first[3])));
+        s = p.val[0];
+        t = p.val[1];
+    }
+#endif
+}
+
+float *ThermalUpscaler::widenRow(const uint16_t *plane, int y) {
+    const uint16_t *src = plane + (size_t) y * width;
+    float *dst = sourceRows.data() + (size_t) (y - firstRow) * rowStride;
+    std::fill(dst, dst + Pad, (float) src[0]);
+    float *row = dst + Pad;
+    int x = 0;
+#if TU_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 8 <= width; x += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + x));
+        _mm_storeu_ps(row + x, _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)));
+        _mm_storeu_ps(row + x + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)));
+    }
+#elif TU_NEON
+    for (; x + 8 <= width; x += 8) {
+        uint16x8_t v = vld1q_u16(src + x);
+        vst1q_f32(row + x, vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))));
+        vst1q_f32(row + x + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))));
+    }
+#endif
+    for (; x < width; ++x) row[x] = (float) src[x];
+    std::fill(row + width, dst + rowStride, (float) src[width - 1]);
+    return dst;
+}
+
+template <int T>
+void ThermalUpscaler::resampleRow(const float *src, const int *first, const float *weight, float *__restrict dst,
+                                  int n) {
+    const int stride = weightStride(T);
+    int x = 0;
+#if TU_SSE2
+    if (T == 2) {
+        for (; x + 4 <= n; x += 4) {
+            __m128 p01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (src + first[x])),
+                                      (const __m64 *) (src + first[x + 1]));
+            __m128 p23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (src + first[x + 2])),
+                                      (const __m64 *) (src + first[x + 3]));
+            p01 = _mm_mul_ps(p01, _mm_loadu_ps(weight + x * 2));
+            p23 = _mm_mul_ps(p23, _mm_loadu_ps(weight + x * 2 + 4));
+            _mm_storeu_ps(dst + x, _mm_add_ps(_mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0)),
+                                              _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1))));
+        }
+    } else if (T > 2) {
+        for (; x + 4 <= n; x += 4) {
+            __m128 sum[4];
+            for (int j = 0; j < 4; ++j) {
+                const float *s = src + first[x + j];
+                const float *w = weight + (x + j) * 8;
+                sum[j] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s), _mm_loadu_ps(w)),
+                                    _mm_mul_ps(_mm_loadu_ps(s + 4), _mm_loadu_ps(w + 4)));
+            }
+            _MM_TRANSPOSE4_PS(sum[0], sum[1], sum[2], sum[3]);
+            _mm_storeu_ps(dst + x, _mm_add_ps(_mm_add_ps(sum[0], sum[1]), _mm_add_ps(sum[2], sum[3])));
+        }
+    }
+#elif TU_NEON
+    if (T == 2) {
+        for (; x + 4 <= n; x += 4) {
+            float32x4_t p01 = vcombine_f32(vld1_f32(src + first[x]), vld1_f32(src + first[x + 1]));
+            float32x4_t p23 = vcombine_f32(vld1_f32(src + first[x + 2]), vld1_f32(src + first[x + 3]));
+            float32x4x2_t products = vuzpq_f32(vmulq_f32(p01, vld1q_f32(weight + x * 2)),
+                                               vmulq_f32(p23, vld1q_f32(weight + x * 2 + 4)));
+            vst1q_f32(dst + x, vaddq_f32(products.val[0], products.val[1]));
+        }
+    } else if (T > 2) {
+        for (; x + 4 <= n; x += 4) {
+            float32x4_t sum[4];
+            for (int j = 0; j < 4; ++j) {
+                const float *s = src + first[x + j];
+                const float *w = weight + (x + j) * 8;
+                sum[j] = vmlaq_f32(vmulq_f32(vld1q_f32(s), vld1q_f32(w)), vld1q_f32(s + 4), vld1q_f32(w + 4));
+            }
+            float32x4x2_t t01 = vtrnq_f32(sum[0], sum[1]);
+            float32x4x2_t t23 = vtrnq_f32(sum[2], sum[3]);
+            float32x4_t even = vaddq_f32(vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])),
+                                         vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+            float32x4_t odd = vaddq_f32(vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])),
+                                        vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+            vst1q_f32(dst + x, vaddq_f32(even, odd));
+        }
+    }
+#endif
+    for (; x < n; ++x) {
+        const float *s = src + first[x];
+        const float *w = weight + x * stride;
+        float v = 0.0f;
+        for (int k = 0; k < T; ++k) v += s[k] * w[k];
+        dst[x] = v;
+    }
+}
+
+template <int T>
+void ThermalUpscaler::blendRows(const float *const *rows, const float *weight, uint16_t *__restrict out, int n) {
+    int x = 0;
+#if TU_SSE2
+    __m128 w[T];
+    for (int k = 0; k < T; ++k) w[k] = _mm_set1_ps(weight[k]);
+    for (; x + 8 <= n; x += 8) {
+        __m128 lo = _mm_set1_ps(0.5f);
+        __m128 hi = lo;
+        for (int k = 0; k < T; ++k) {
+            lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(rows[k] + x), w[k]));
+            hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(rows[k] + x + 4), w[k]));
+        }
+        _mm_storeu_si128((__m128i *) (out + x), packClamped(lo, hi));
+    }
+#elif TU_NEON
+    float32x4_t w[T];
+    for (int k = 0; k < T; ++k) w[k] = vdupq_n_f32(weight[k]);
+    for (; x + 8 <= n; x += 8) {
+        float32x4_t lo = vdupq_n_f32(0.5f);
+        float32x4_t hi = lo;
+        for (int k = 0; k < T; ++k) {
+            lo = vmlaq_f32(lo, vld1q_f32(rows[k] + x), w[k]);
+            hi = vmlaq_f32(hi, vld1q_f32(rows[k] + x + 4), w[k]);
+        }
+        vst1q_u16(out + x, packClamped(lo, hi));
+    }
+#endif
+    for (; x < n; ++x) {
+        float v = 0.5f;
+        for (int k = 0; k < T; ++k) v += rows[k][x] * weight[k];
+        out[x] = (uint16_t) std::min(std::max(v, 0.0f), 65535.0f);
+    }
+}
+
+const char *ThermalUpscaler::methodName(Method method) {
+    switch (method) {
+        case Method::Nearest: return "nearest";
+        case Method::Bilinear: return "bilinear";
+        case Method::Lanczos: return "lanczos";
+        case Method::EdgeDirected: return "edge-directed";
+        default: return "?";
+    }
+}
+
+ThermalUpscaler::ThermalUpscaler(int w, int h) : width(w), height(h), rowStride(w + 4 * Pad) {
+}
+
+void ThermalUpscaler::buildAxis(int start, int length, int outLength, int limit, std::vector<Taps> &taps) const {
+    taps.resize(outLength);
+    const double step = (double) length / outLength;
+    for (int o = 0; o < outLength; ++o) {
+        Taps &t = taps[o];
+        // Source position of the output pixel's centre, in source pixel coordinates
+        double u = start + (o + 0.5) * step - 0.5;
+
+        switch (cachedMethod) {
+            case Method::Nearest:
+                t.index[0] = std::min(std::max((int) std::floor(u + 0.5), 0), limit - 1);
+                t.weight[0] = 1.0f;
+                t.first = t.index[0];
+                break;
+            case Method::Bilinear:
+            case Method::EdgeDirected: {
+                // Replicated borders: clamping the position is the same as clamping both samples
+                double c = std::min(std::max(u, 0.0), (double) (limit - 1));
+                int i = std::min((int) c, limit - 2);
+                float f = (float) (c - i);
+                t.index[0] = i;
+                t.index[1] = i + 1;
+                t.weight[0] = 1.0f - f;
+                t.weight[1] = f;
+                t.first = i;
+                // The edge-directed pass reads the cell's origin and fraction from index[0], weight[1]
+                break;
+            }
+            case Method::Lanczos: {
+                int i = (int) std::floor(u);
+                float sum = 0.0f;
+                for (int k = 0; k < 6; ++k) {
+                    int s = i - 2 + k;
+                    float x = (float) (u - s);
+                    float wk = sinc(x) * sinc(x / 3.0f);
+                    t.index[k] = std::min(std::max(s, 0), limit - 1);
+                    t.weight[k] = wk;
+                    sum += wk;
+                }
+                for (int k = 0; k < 6; ++k) t.weight[k] /= sum;
+                // At least -3 (u > -0.5) and at most limit - 3, within the widened row's borders
+                t.first = i - 2;
+                break;
+            }
+        }
+    }
+}
+
+void ThermalUpscaler::buildTaps(int x0, int y0, int w, int h, int outW, int outH, Method method) {
+    if (x0 == cachedX0 && y0 == cachedY0 && w == cachedW && h == cachedH && outW == cachedOutW &&
+        outH == cachedOutH && method == cachedMethod && !columnTaps.empty()) {
+        return;
+    }
+    cachedX0 = x0;
+    cachedY0 = y0;
+    cachedW = w;
+    cachedH = h;
+    cachedOutW = outW;
+    cachedOutH = outH;
+    cachedMethod = method;
+    tapCount = method == Method::Nearest ? 1 : method == Method::Lanczos ? 6 : 2;
+
+    buildAxis(x0, w, outW, width, columnTaps);
+    buildAxis(y0, h, outH, height, rowTaps);
+
+    const int stride = weightStride(tapCount);
+    columnFirst.resize(outW);
+    columnWeights.assign((size_t) outW * stride, 0.0f);
+    for (int x = 0; x < outW; ++x) {
+        columnFirst[x] = columnTaps[x].first + Pad;
+        for (int k = 0; k < tapCount; ++k) columnWeights[(size_t) x * stride + k] = columnTaps[x].weight[k];
+    }
+
+    firstRow = height - 1;
+    lastRow = 0;
+    for (const Taps &t: rowTaps) {
+        for (int k = 0; k < tapCount; ++k) {
+            firstRow = std::min(firstRow, t.index[k]);
+            lastRow = std::max(lastRow, t.index[k]);
+        }
+    }
+    sourceRows.resize((size_t) (lastRow - firstRow + 1) * rowStride);
+    horizontal.resize((size_t) (lastRow - firstRow + 1) * outW);
+}
+
+void ThermalUpscaler::process(const uint16_t *plane, int x0, int y0, int w, int h, uint16_t *out, int outW,
+                              int outH, Method method, ThreadPool *pool) {
+    if (w <= 0 || h <= 0 || outW <= 0 || outH <= 0) return;
+    buildTaps(x0, y0, w, h, outW, outH, method);
+
+    if (method == Method::EdgeDirected) {
+        edgeDirected(plane, out, outW, outH, pool);
+    } else {
+        separable(plane, out, outW, outH, pool);
+    }
+}
+
+void ThermalUpscaler::separable(const uint16_t *plane, uint16_t *out, int outW, int outH, ThreadPool *pool) {
+    const int rows = lastRow - firstRow + 1;
+
+    // 1. Horizontal pass over only the source rows the vertical taps reach
+    forEachBand(pool, rows, [&](int r0, int r1) {
+        for (int r = r0; r < r1; ++r) {
+            const float *src = widenRow(plane, firstRow + r);
+            float *dst = horizontal.data() + (size_t) r * outW;
+            switch (tapCount) {
+                case 1: resampleRow<1>(src, columnFirst.data(), columnWeights.data(), dst, outW); break;
+                case 2: resampleRow<2>(src, columnFirst.data(), columnWeights.data(), dst, outW); break;
+                default: resampleRow<6>(src, columnFirst.data(), columnWeights.data(), dst, outW); break;
+            }
+        }
+    }, 8);
+
+    // 2. Vertical pass: each output row blends whole intermediate rows
+    forEachBand(pool, outH, [&](int y0, int y1) {
+        const float *rowPtr[MaxTaps];
+        for (int y = y0; y < y1; ++y) {
+            const Taps &t = rowTaps[y];
+            for (int k = 0; k < tapCount; ++k) {
+                rowPtr[k] = horizontal.data() + (size_t) (t.index[k] - firstRow) * outW;
+            }
+            uint16_t *dst = out + (size_t) y * outW;
+            switch (tapCount) {
+                case 1: blendRows<1>(rowPtr, t.weight, dst, outW); break;
+                case 2: blendRows<2>(rowPtr, t.weight, dst, outW); break;
+                default: blendRows<6>(rowPtr, t.weight, dst, outW); break;
+            }
+        }
+    }, 32);
+}
+
+void ThermalUpscaler::edgeDirected(const uint16_t *plane, uint16_t *out, int outW, int outH, ThreadPool *pool) {
+    // Each source cell is split into two triangles along the diagonal with the smaller difference
+    // and interpolated linearly on the triangle the output pixel falls in. Edges running
+    // diagonally through a cell are followed instead of being blurred into a staircase. The
+    // vector paths evaluate all four triangle formulas and select with comparison masks.
+    forEachBand(pool, lastRow - firstRow + 1, [&](int r0, int r1) {
+        for (int r = r0; r < r1; ++r) widenRow(plane, firstRow + r);
+    }, 8);
+
+    forEachBand(pool, outH, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const Taps &ty = rowTaps[y];
+            const float *r0 = sourceRows.data() + (size_t) (ty.index[0] - firstRow) * rowStride;
+            const float *r1 = sourceRows.data() + (size_t) (ty.index[1] - firstRow) * rowStride;
+            const float fy = ty.weight[1];
+            uint16_t *dst = out + (size_t) y * outW;
+            const int *first = columnFirst.data();
+            const float *weight = columnWeights.data();
+            int x = 0;
+#if TU_SSE2
+            const __m128 vfy = _mm_set1_ps(fy);
+            const __m128 gy = _mm_set1_ps(1.0f - fy);
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            for (; x + 8 <= outW; x += 8) {
+                __m128 v[2];
+                for (int j = 0; j < 2; ++j) {
+                    const int xj = x + j * 4;
+                    __m128 a, b, c, d;
+                    loadPairs(r0, first + xj, a, b);
+                    loadPairs(r1, first + xj, c, d);
+                    __m128 w01 = _mm_loadu_ps(weight + xj * 2);
+                    __m128 w23 = _mm_loadu_ps(weight + xj * 2 + 4);
+                    __m128 fx = _mm_shuffle_ps(w01, w23, _MM_SHUFFLE(3, 1, 3, 1));
+                    __m128 gx = _mm_shuffle_ps(w01, w23, _MM_SHUFFLE(2, 0, 2, 0));
+
+                    __m128 ab = _mm_add_ps(a, _mm_mul_ps(fx, _mm_sub_ps(b, a)));
+                    __m128 upper = _mm_add_ps(ab, _mm_mul_ps(vfy, _mm_sub_ps(d, b)));
+                    __m128 lower = _mm_add_ps(_mm_add_ps(a, _mm_mul_ps(vfy, _mm_sub_ps(c, a))),
+                                              _mm_mul_ps(fx, _mm_sub_ps(d, c)));
+                    __m128 nearA = _mm_add_ps(ab, _mm_mul_ps(vfy, _mm_sub_ps(c, a)));
+                    __m128 nearD = _mm_add_ps(_mm_add_ps(d, _mm_mul_ps(gx, _mm_sub_ps(c, d))),
+                                              _mm_mul_ps(gy, _mm_sub_ps(b, d)));
+                    __m128 mainDiagonal = _mm_cmple_ps(_mm_and_ps(_mm_sub_ps(a, d), absMask),
+                                                       _mm_and_ps(_mm_sub_ps(b, c), absMask));
+                    __m128 alongMain = select(_mm_cmpge_ps(fx, vfy), upper, lower);
+                    __m128 alongAnti = select(_mm_cmple_ps(_mm_add_ps(fx, vfy), one), nearA, nearD);
+                    v[j] = _mm_add_ps(select(mainDiagonal, alongMain, alongAnti), _mm_set1_ps(0.5f));
+                }
+                _mm_storeu_si128((__m128i *) (dst + x), packClamped(v[0], v[1]));
+            }
+#elif TU_NEON
+            const float32x4_t vfy = vdupq_n_f32(fy);
+            const float32x4_t gy = vdupq_n_f32(1.0f - fy);
+            const float32x4_t one = vdupq_n_f32(1.0f);
+            for (; x + 8 <= outW; x += 8) {
+                float32x4_t v[2];
+                for (int j = 0; j < 2; ++j) {
+                    const int xj = x + j * 4;
+                    float32x4_t a, b, c, d;
+                    loadPairs(r0, first + xj, a, b);
+                    loadPairs(r1, first + xj, c, d);
+                    float32x4x2_t w = vuzpq_f32(vld1q_f32(weight + xj * 2), vld1q_f32(weight + xj * 2 + 4));
+                    float32x4_t gx = w.val[0];
+                    float32x4_t fx = w.val[1];
+
+                    float32x4_t ab = vmlaq_f32(a, fx, vsubq_f32(b, a));
+                    float32x4_t upper = vmlaq_f32(ab, vfy, vsubq_f32(d, b));
+                    float32x4_t lower = vmlaq_f32(vmlaq_f32(a, vfy, vsubq_f32(c, a)), fx, vsubq_f32(d, c));
+                    float32x4_t nearA = vmlaq_f32(ab, vfy, vsubq_f32(c, a));
+                    float32x4_t nearD = vmlaq_f32(vmlaq_f32(d, gx, vsubq_f32(c, d)), gy, vsubq_f32(b, d));
+                    uint32x4_t mainDiagonal = vcleq_f32(vabdq_f32(a, d), vabdq_f32(b, c));
+                    float32x4_t alongMain = vbslq_f32(vcgeq_f32(fx, vfy), upper, lower);
+                    float32x4_t alongAnti = vbslq_f32(vcleq_f32(vaddq_f32(fx, vfy), one), nearA, nearD);
+                    v[j] = vaddq_f32(vbslq_f32(mainDiagonal, alongMain, alongAnti), vdupq_n_f32(0.5f));
+                }
+                vst1q_u16(dst + x, packClamped(v[0], v[1]));
+            }
+#endif
+            for (; x < outW; ++x) {
+                const float *p0 = r0 + first[x];
+                const float *p1 = r1 + first[x];
+                const float fx = weight[x * 2 + 1];
+                float a = p0[0], b = p0[1], c = p1[0], d = p1[1];
+                float v;
+                if (std::fabs(a - d) <= std::fabs(b - c)) {
+                    v = fx >= fy ? a + fx * (b - a) + fy * (d - b) : a + fy * (c - a) + fx * (d - c);
+                } else {
+                    v = fx + fy <= 1.0f ? a + fx * (b - a) + fy * (c - a)
+                                        : d + (1.0f - fx) * (c - d) + (1.0f - fy) * (b - d);
+                }
+                dst[x] = (uint16_t) (v + 0.5f);
+            }
+        }
+    }, 32);
+}
@@ -0,0 +1,81 @@
+#ifndef THERMAL_UPSCALER_HPP
+#define THERMAL_UPSCALER_HPP
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Resamples a rectangular region of the Y16 thermal plane to a larger output size, so zoomed
+// views are interpolated on the raw values before AGC and colorization instead of stretching
+// palette colors. Only the region's source pixels (plus the filter support around it) are
+// read and only the output size is computed.
+class ThermalUpscaler {
+public:
+    enum class Method {
+        Nearest,
+        Bilinear,
+        Lanczos,      // Lanczos-3, sharpest, may ring slightly at hard edges
+        EdgeDirected  // bilinear on triangles split along the flatter diagonal of each cell
+    };
+
+    static const char *methodName(Method method);
+
+    ThermalUpscaler(int width, int height);
+
+    // Resamples the w x h region at (x0, y0) of the width x height plane into outW x outH pixels,
+    // with pixel centres aligned. Output rows are processed in bands on the given pool, or inline
+    // when pool is null. Tap tables are only rebuilt when the region, output size or method change.
+    void process(const uint16_t *plane, int x0, int y0, int w, int h, uint16_t *out, int outW, int outH,
+                 Method method, ThreadPool *pool = nullptr);
+
+private:
+    static const int MaxTaps = 6;
+    static const int Pad = 4; // replicated border samples left of each widened source row
+
+    // Source samples and weights contributing to one output column or row
+    struct Taps {
+        int first; // unclamped index of the first sample; the taps are contiguous from there
+        int index[MaxTaps];
+        float weight[MaxTaps];
+    };
+
+    // Column weights are stored per output pixel with this stride, Lanczos padded to 8 with zeros
+    // so each pixel's taps are read with two whole vector loads
+    static constexpr int weightStride(int taps) { return taps > 2 ? 8 : taps; }
+
+    int width;
+    int height;
+    int rowStride; // floats per widened source row: the row with replicated borders on both sides
+
+    // Geometry the tap tables were built for
+    int cachedX0 = -1, cachedY0 = -1, cachedW = 0, cachedH = 0, cachedOutW = 0, cachedOutH = 0;
+    Method cachedMethod = Method::Nearest;
+    int tapCount = 0;
+    std::vector<Taps> columnTaps;
+    std::vector<Taps> rowTaps;
+    int firstRow = 0; // source rows [firstRow, lastRow] feed the vertical pass
+    int lastRow = 0;
+
+    // Column taps in the layout the kernels read: first sample in widened row coordinates and
+    // weightStride(tapCount) weights per output pixel
+    std::vector<int> columnFirst;
+    std::vector<float> columnWeights;
+
+    // Source rows [firstRow, lastRow] as floats with replicated borders, rowStride floats each
+    std::vector<float> sourceRows;
+    // Horizontally resampled source rows, outW floats each
+    std::vector<float> horizontal;
+
+    void buildTaps(int x0, int y0, int w, int h, int outW, int outH, Method method);
+    void buildAxis(int start, int length, int outLength, int limit, std::vector<Taps> &taps) const;
+    float *widenRow(const uint16_t *plane, int y);
+    template <int T>
+    static void resampleRow(const float *src, const int *first, const float *weight, float *dst, int n);
+    template <int T>
+    static void blendRows(const float *const *rows, const float *weight, uint16_t *out, int n);
+    void separable(const uint16_t *plane, uint16_t *out, int outW, int outH, ThreadPool *pool);
+    void edgeDirected(const uint16_t *plane, uint16_t *out, int outW, int outH, ThreadPool *pool);
+};
+
+#endif
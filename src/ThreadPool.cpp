@@ -0,0 +1,108 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = (int) std::thread::hardware_concurrency();
+        if (threadCount <= 0) threadCount = 1;
+    }
+
+    // The calling thread is the first executor, so we only spawn threadCount - 1 workers
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCv.notify_all();
+    for (auto &t: workers) {
+        t.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::runJob(const std::function<void(int)> &fn, int count) {
+    while (true) {
+        int i = nextIndex.fetch_add(1, std::memory_order_relaxed);
+        if (i >= count) break;
+        fn(i);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        const std::function<void(int)> *fn;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCv.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            // A worker that wakes up late may find the job already finished
+            if (!job) continue;
+            fn = job;
+            count = jobCount;
+            activeWorkers++;
+        }
+
+        runJob(*fn, count);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        doneCv.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)> &fn) {
+    if (count <= 0) return;
+    if (workers.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitLock(submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        nextIndex.store(0, std::memory_order_relaxed);
+        generation++;
+    }
+    wakeCv.notify_all();
+
+    runJob(fn, count);
+
+    // Wait until every worker that picked up this generation has left runJob()
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [&] { return activeWorkers == 0; });
+    job = nullptr;
+    jobCount = 0;
+}
+
+void ThreadPool::parallelForBands(int rows, const std::function<void(int, int)> &fn, int minRows) {
+    if (rows <= 0) return;
+    minRows = std::max(1, minRows);
+    int bands = std::max(1, std::min(size(), rows / minRows));
+    if (bands == 1) {
+        fn(0, rows);
+        return;
+    }
+
+    auto runBand = [&](int band) {
+        int begin = (int) ((int64_t) rows * band / bands);
+        int end = (int) ((int64_t) rows * (band + 1) / bands);
+        fn(begin, end);
+    };
+    parallelFor(bands, std::cref(runBand));
+}
@@ -0,0 +1,63 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed-size worker pool for data-parallel image kernels.
+// The calling thread always takes part in the work, so a pool of size 1 runs everything inline.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threadCount = 0); // 0 = one thread per hardware core
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of threads that execute work, including the caller
+    int size() const { return (int) workers.size() + 1; }
+
+    // Runs fn(i) for every i in [0, count) and blocks until all calls have returned
+    void parallelFor(int count, const std::function<void(int)> &fn);
+
+    // Splits [0, rows) into contiguous bands of at least minRows rows and runs fn(begin, end) for each
+    void parallelForBands(int rows, const std::function<void(int, int)> &fn, int minRows = 16);
+
+    // Process-wide pool shared by all views and streams
+    static ThreadPool &shared();
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex submitMutex; // serializes concurrent parallelFor() callers
+    std::mutex mutex;
+    std::condition_variable wakeCv;
+    std::condition_variable doneCv;
+
+    const std::function<void(int)> *job = nullptr;
+    int jobCount = 0;
+    std::atomic<int> nextIndex{0};
+    int activeWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void runJob(const std::function<void(int)> &fn, int count);
+};
+
+// Runs fn(begin, end) over row bands on the pool, or over all rows inline when pool is null.
+// The callable is passed on by reference, which std::function stores without allocating.
+template <typename Fn>
+inline void forEachBand(ThreadPool *pool, int rows, const Fn &fn, int minRows = 16) {
+    if (pool) {
+        pool->parallelForBands(rows, std::cref(fn), minRows);
+    } else {
+        fn(0, rows);
+    }
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+// Latest-value handoff between one writer and one reader thread without locks or waiting. The
+// writer fills its back slot and publishes it; the reader picks up the newest published slot and
+// reads it for as long as it likes. The third slot sits in between, so neither side ever blocks
+// the other, the writer simply overwrites values the reader never got to, and the reader always
+// sees the most recent one.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer: the slot to fill next; it holds whatever value was last swapped out of it
+    T &back() { return slots[backIndex]; }
+
+    // Writer: makes the back slot the newest value
+    void publish() {
+        int previous = middle.exchange(backIndex | Fresh, std::memory_order_acq_rel);
+        backIndex = previous & IndexMask;
+    }
+
+    // Reader: takes the newest value if one was published since the last call
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & Fresh)) return false;
+        int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & IndexMask;
+        return true;
+    }
+
+    // Reader: the value taken by the last successful update()
+    const T &front() const { return slots[frontIndex]; }
+
+private:
+    static const int IndexMask = 3;
+    static const int Fresh = 4;
+
+    T slots[3];
+    int backIndex = 0;           // writer only
+    int frontIndex = 1;          // reader only
+    std::atomic<int> middle{2};  // slot index in between, plus Fresh once published
+};
+
+#endif
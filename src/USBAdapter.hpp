@@ -5,6 +5,12 @@
 #include <cstdint>
 #include <string>
 
+// When and in what order the driver captured a frame
+struct FrameInfo {
+    int64_t timestamp_us = 0; // steady clock (CLOCK_MONOTONIC on Linux)
+    uint32_t sequence = 0;    // driver frame counter; gaps are frames lost before they were read
+};
+
 class USBAdapter {
 public:
     virtual ~USBAdapter() = default;
@@ -18,7 +24,7 @@ public:
     virtual bool is_connected() const = 0;
 
     virtual bool open_video() = 0;
-    virtual bool read_frame(std::vector<uint8_t>& frame_data) = 0;
+    virtual bool read_frame(std::vector<uint8_t>& frame_data, FrameInfo* info = nullptr) = 0;
 };
 
 #endif
@@ -5,6 +5,7 @@
 #include <sys/mman.h>
 #include <linux/videodev2.h>
 #include <cstring>
+#include <chrono>
 #include <iostream>
 #include "P2Pro.hpp" // For dprintf
 
@@ -120,7 +121,7 @@ void V4L2VideoSource::close() {
     }
 }
 
-bool V4L2VideoSource::getFrame(std::vector<uint8_t> &frameData) {
+bool V4L2VideoSource::getFrame(std::vector<uint8_t> &frameData, int64_t *timestampUs, uint32_t *sequence) {
     if (fd == -1) return false;
 
     // Use poll to wait for data if it's not immediately available
@@ -128,8 +129,11 @@ bool V4L2VideoSource::getFrame(std::vector<uint8_t> &frameData) {
     pfd.fd = fd;
     pfd.events = POLLIN;
 
-    // We wait up to 100ms for a frame
-    int ret = poll(&pfd, 1, 100);
+    // We wait up to 100ms for a frame; a signal handled on this thread is not a lost device
+    int ret;
+    do {
+        ret = poll(&pfd, 1, 100);
+    } while (ret < 0 && errno == EINTR);
     if (ret <= 0) {
         return false;
     }
@@ -139,7 +143,11 @@ bool V4L2VideoSource::getFrame(std::vector<uint8_t> &frameData) {
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf.memory = V4L2_MEMORY_MMAP;
 
-    if (ioctl(fd, VIDIOC_DQBUF, &buf) < 0) {
+    int dequeued;
+    do {
+        dequeued = ioctl(fd, VIDIOC_DQBUF, &buf);
+    } while (dequeued < 0 && errno == EINTR);
+    if (dequeued < 0) {
         return false;
     }
 
@@ -150,6 +158,17 @@ bool V4L2VideoSource::getFrame(std::vector<uint8_t> &frameData) {
 
     frameData.assign((uint8_t *) buffers[buf.index].start, (uint8_t *) buffers[buf.index].start + buf.bytesused);
 
+    if (timestampUs) {
+        // UVC drivers stamp monotonic time at capture; anything else falls back to the dequeue time
+        if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+            *timestampUs = (int64_t) buf.timestamp.tv_sec * 1000000 + buf.timestamp.tv_usec;
+        } else {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            *timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+        }
+    }
+    if (sequence) *sequence = buf.sequence;
+
     if (ioctl(fd, VIDIOC_QBUF, &buf) < 0) {
         return false;
     }
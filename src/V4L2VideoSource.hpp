@@ -14,7 +14,9 @@ public:
     void close();
     bool isOpened() const { return fd != -1; }
 
-    bool getFrame(std::vector<uint8_t>& frameData);
+    // timestampUs is the capture time on CLOCK_MONOTONIC (the steady clock), sequence the
+    // driver's frame counter
+    bool getFrame(std::vector<uint8_t>& frameData, int64_t* timestampUs = nullptr, uint32_t* sequence = nullptr);
 
 private:
     int fd = -1;
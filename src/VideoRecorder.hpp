@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include "ColorConversion.hpp"
 
 class VideoRecorder {
 public:
@@ -14,6 +15,12 @@ public:
     void stop();
     void writeFrame(const std::vector<uint8_t>& rgb_data);
 
+    // Direct YUV path: beginFrame() exposes the planes of the next encoder frame so the caller
+    // can fill them in place (e.g. with ColorConversion::YUY2toYUV420P) and draw overlays,
+    // then submitFrame() encodes it. Avoids the RGB round trip and the per-frame copy.
+    bool beginFrame(ColorConversion::PlanarYUV420& planes);
+    void submitFrame();
+
     bool isRecording() const { return recording; }
     std::string getFilename() const { return filename; }
 
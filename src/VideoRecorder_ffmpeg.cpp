@@ -21,6 +21,30 @@ struct VideoRecorderImpl {
     SwsContext* sws_ctx = nullptr;
 };
 
+// Sends the staged frame (or a flush request) to the encoder and writes out all ready packets
+static void encodeFrame(VideoRecorderImpl* v, bool hasFrame) {
+    // Encode
+    int ret = avcodec_send_frame(v->codec_ctx, hasFrame ? v->frame : NULL);
+    if (ret < 0) return;
+
+    while (ret >= 0) {
+        AVPacket* pkt = av_packet_alloc();
+        ret = avcodec_receive_packet(v->codec_ctx, pkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            av_packet_free(&pkt);
+            break;
+        } else if (ret < 0) {
+            av_packet_free(&pkt);
+            break;
+        }
+
+        av_packet_rescale_ts(pkt, v->codec_ctx->time_base, v->stream->time_base);
+        pkt->stream_index = v->stream->index;
+        av_interleaved_write_frame(v->fmt_ctx, pkt);
+        av_packet_free(&pkt);
+    }
+}
+
 VideoRecorder::VideoRecorder() {
     impl = new VideoRecorderImpl();
 }
@@ -91,6 +115,8 @@ bool VideoRecorder::start(int w, int h, double f) {
     v->codec_ctx->time_base = v->stream->time_base;
     v->codec_ctx->gop_size = 12;
     v->codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    // The camera delivers full range YUV, which the direct YUV path passes through unchanged
+    v->codec_ctx->color_range = AVCOL_RANGE_JPEG;
 
     if (v->fmt_ctx->oformat->flags & AVFMT_GLOBALHEADER)
         v->codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
@@ -145,10 +171,14 @@ bool VideoRecorder::start(int w, int h, double f) {
         return false;
     }
 
-    // 8. Initialize SWS context for RGB to YUV420P conversion
+    // 8. Initialize SWS context for RGB to YUV420P conversion (full range to match the direct path)
     v->sws_ctx = sws_getContext(width, height, AV_PIX_FMT_RGB24,
                              width, height, AV_PIX_FMT_YUV420P,
                              SWS_BICUBIC, NULL, NULL, NULL);
+    if (v->sws_ctx) {
+        const int* coeffs = sws_getCoefficients(SWS_CS_ITU601);
+        sws_setColorspaceDetails(v->sws_ctx, coeffs, 1, coeffs, 1, 0, 1 << 16, 1 << 16);
+    }
 
     dprintf("VideoRecorder::start() - Recording started (FFmpeg): %s (%dx%d @ %.1f FPS)\n", filename.c_str(), width, height, fps);
     recording = true;
@@ -196,6 +226,7 @@ void VideoRecorder::writeFrame(const std::vector<uint8_t>& rgb_data) {
 
     if (!rgb_data.empty()) {
         if (rgb_data.size() != static_cast<size_t>(width * height * 3)) return;
+        if (av_frame_make_writable(v->frame) < 0) return;
 
         // Convert RGB24 to YUV420P
         const uint8_t* inData[1] = { rgb_data.data() };
@@ -205,24 +236,32 @@ void VideoRecorder::writeFrame(const std::vector<uint8_t>& rgb_data) {
         v->frame->pts = frame_count++;
     }
 
-    // Encode
-    int ret = avcodec_send_frame(v->codec_ctx, rgb_data.empty() ? NULL : v->frame);
-    if (ret < 0) return;
+    encodeFrame(v, !rgb_data.empty());
+}
 
-    while (ret >= 0) {
-        AVPacket* pkt = av_packet_alloc();
-        ret = avcodec_receive_packet(v->codec_ctx, pkt);
-        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-            av_packet_free(&pkt);
-            break;
-        } else if (ret < 0) {
-            av_packet_free(&pkt);
-            break;
-        }
+bool VideoRecorder::beginFrame(ColorConversion::PlanarYUV420& planes) {
+    if (!recording) return false;
 
-        av_packet_rescale_ts(pkt, v->codec_ctx->time_base, v->stream->time_base);
-        pkt->stream_index = v->stream->index;
-        av_interleaved_write_frame(v->fmt_ctx, pkt);
-        av_packet_free(&pkt);
-    }
+    VideoRecorderImpl* v = static_cast<VideoRecorderImpl*>(impl);
+
+    // The encoder may still reference the previous frame's buffers
+    if (av_frame_make_writable(v->frame) < 0) return false;
+
+    planes.y = v->frame->data[0];
+    planes.u = v->frame->data[1];
+    planes.v = v->frame->data[2];
+    planes.strideY = v->frame->linesize[0];
+    planes.strideU = v->frame->linesize[1];
+    planes.strideV = v->frame->linesize[2];
+    planes.width = width;
+    planes.height = height;
+    return true;
+}
+
+void VideoRecorder::submitFrame() {
+    if (!recording) return;
+
+    VideoRecorderImpl* v = static_cast<VideoRecorderImpl*>(impl);
+    v->frame->pts = frame_count++;
+    encodeFrame(v, true);
 }
@@ -18,6 +18,7 @@
 
 struct VideoRecorderImpl {
     MacOSVideoRecorder* recorder;
+    std::vector<uint8_t> yuvFrame; // I420 staging frame for beginFrame()/submitFrame()
 };
 
 VideoRecorder::VideoRecorder() {
@@ -123,10 +124,10 @@ void VideoRecorder::cleanup() {
     // Handled in stop() and destructor
 }
 
-void VideoRecorder::writeFrame(const std::vector<uint8_t>& rgb_data) {
-    if (!recording || rgb_data.empty()) return;
-
-    VideoRecorderImpl* v = static_cast<VideoRecorderImpl*>(impl);
+// Obtains a BGRA pixel buffer, lets fill() write the image into it and appends it to the writer
+template <typename Fill>
+static void appendPixels(void* implPtr, int width, int height, int64_t& frame_count, double fps, Fill fill) {
+    VideoRecorderImpl* v = static_cast<VideoRecorderImpl*>(implPtr);
     if (!v->recorder.input.isReadyForMoreMediaData) return;
 
     CVPixelBufferRef pixelBuffer = NULL;
@@ -142,9 +143,24 @@ void VideoRecorder::writeFrame(const std::vector<uint8_t>& rgb_data) {
 
     if (status == kCVReturnSuccess && pixelBuffer) {
         CVPixelBufferLockBaseAddress(pixelBuffer, 0);
-        uint8_t *baseAddress = (uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer);
-        size_t bytesPerRow = CVPixelBufferGetBytesPerRow(pixelBuffer);
+        fill((uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer), CVPixelBufferGetBytesPerRow(pixelBuffer));
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+
+        CMTime frameTime = CMTimeMake(frame_count, (int)fps);
+        if (![v->recorder.adaptor appendPixelBuffer:pixelBuffer withPresentationTime:frameTime]) {
+            dprintf("VideoRecorder::writeFrame() - Error appending pixel buffer: %s\n", [[v->recorder.writer.error localizedDescription] UTF8String]);
+        }
+        
+        CVPixelBufferRelease(pixelBuffer);
+        frame_count++;
+    }
+}
+
+void VideoRecorder::writeFrame(const std::vector<uint8_t>& rgb_data) {
+    if (!recording || rgb_data.empty()) return;
+    if (rgb_data.size() != static_cast<size_t>(width * height * 3)) return;
 
+    appendPixels(impl, width, height, frame_count, fps, [&](uint8_t* baseAddress, size_t bytesPerRow) {
         for (int y = 0; y < height; ++y) {
             uint8_t *dst = baseAddress + y * bytesPerRow;
             const uint8_t *src = rgb_data.data() + y * width * 3;
@@ -155,14 +171,36 @@ void VideoRecorder::writeFrame(const std::vector<uint8_t>& rgb_data) {
                 dst[x*4 + 3] = 255;          // A
             }
         }
-        CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+    });
+}
 
-        CMTime frameTime = CMTimeMake(frame_count, (int)fps);
-        if (![v->recorder.adaptor appendPixelBuffer:pixelBuffer withPresentationTime:frameTime]) {
-            dprintf("VideoRecorder::writeFrame() - Error appending pixel buffer: %s\n", [[v->recorder.writer.error localizedDescription] UTF8String]);
-        }
-        
-        CVPixelBufferRelease(pixelBuffer);
-        frame_count++;
-    }
+bool VideoRecorder::beginFrame(ColorConversion::PlanarYUV420& planes) {
+    if (!recording) return false;
+
+    VideoRecorderImpl* v = static_cast<VideoRecorderImpl*>(impl);
+    size_t lumaSize = (size_t) width * height;
+    size_t chromaSize = (size_t) (width / 2) * (height / 2);
+    v->yuvFrame.resize(lumaSize + 2 * chromaSize);
+
+    planes.y = v->yuvFrame.data();
+    planes.u = planes.y + lumaSize;
+    planes.v = planes.u + chromaSize;
+    planes.strideY = width;
+    planes.strideU = width / 2;
+    planes.strideV = width / 2;
+    planes.width = width;
+    planes.height = height;
+    return true;
+}
+
+void VideoRecorder::submitFrame() {
+    if (!recording) return;
+
+    ColorConversion::PlanarYUV420 planes;
+    if (!beginFrame(planes)) return;
+
+    // AVAssetWriter is fed BGRA, so the staged YUV frame is converted straight into the pixel buffer
+    appendPixels(impl, width, height, frame_count, fps, [&](uint8_t* baseAddress, size_t bytesPerRow) {
+        ColorConversion::YUV420PtoBGRA(planes, baseAddress, (int) bytesPerRow);
+    });
 }
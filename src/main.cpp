@@ -1,20 +1,50 @@
 #include "P2Pro.hpp"
 #include "CameraWindow.hpp"
 #include "VideoRecorder.hpp"
+#include "ColorConversion.hpp"
+#include "ThermalCalibration.hpp"
+#include "FrameStats.hpp"
+#include "BlobDetector.hpp"
+#include "BlobTracker.hpp"
+#include "RoiAnalyzer.hpp"
+#include "TemporalFilter.hpp"
+#include "BadPixelCorrector.hpp"
+#include "BadPixelAnalyzer.hpp"
+#include "FlatFieldCorrector.hpp"
+#include "PixelStatsAccumulator.hpp"
+#include "AlarmEngine.hpp"
+#include "DeviceStorage.hpp"
+#include "ThreadPool.hpp"
+#include "FramePool.hpp"
+#include "TripleBuffer.hpp"
+#include "PipelineMetrics.hpp"
+#include "ControlServer.hpp"
+#include "ColorbarLegend.hpp"
+#include <atomic>
+#include <mutex>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <vector>
-#include <deque>
 #include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <memory>
 
 class HotSpotTracker {
 public:
     struct Sample {
-        double x, y, temp;
+        float x, y;
+        double temp;
+        float peak;
         uint8_t r, g, b;
     };
 
+    // At most three samples; reserved once so the per-frame push and pop never allocate
+    HotSpotTracker() { history.reserve(3); }
+
     void update(HotSpotResult &res, const P2ProFrame &frame) {
         if (!res.found) {
             lostFrames++;
@@ -30,7 +60,7 @@ public:
         }
 
         lostFrames = 0;
-        Sample current = {(double) res.x, (double) res.y, res.tempC, res.r, res.g, res.b};
+        Sample current = {res.fx, res.fy, res.temperature, res.peak, res.r, res.g, res.b};
 
         if (!history.empty()) {
             double lastX = history.back().x;
@@ -44,37 +74,40 @@ public:
         }
 
         history.push_back(current);
-        if (history.size() > 8) {
-            history.pop_front();
+        if (history.size() > 2) {
+            history.erase(history.begin());
         }
 
         applyHistory(res);
     }
 
 private:
-    std::deque<Sample> history;
+    std::vector<Sample> history;
     int lostFrames = 0;
 
     void applyHistory(HotSpotResult &res) {
         if (history.empty()) return;
 
-        double avgX = 0, avgY = 0;
         double maxTemp = -1000.0;
         Sample bestSample = history.back();
 
         for (const auto &s: history) {
-            avgX += s.x;
-            avgY += s.y;
             if (s.temp > maxTemp) {
                 maxTemp = s.temp;
                 bestSample = s; // Use color and temp from the hottest sample
             }
         }
 
-        res.x = (int) std::round(avgX / history.size());
-        res.y = (int) std::round(avgY / history.size());
+        // The sub-pixel position is already stable, so the newest sample is used as is;
+        // averaging positions over the history only added lag
+        const Sample &latest = history.back();
+        res.fx = latest.x;
+        res.fy = latest.y;
+        res.x = (int) std::lround(latest.x);
+        res.y = (int) std::lround(latest.y);
         // Use max temperature from buffer as requested: "if any modification is done to temperature, it must use max, not average"
-        res.tempC = maxTemp;
+        res.temperature = maxTemp;
+        res.peak = bestSample.peak;
 
         // Use color from the hottest sample for better contrast consistency
         res.r = bestSample.r;
@@ -83,37 +116,26 @@ private:
     }
 };
 
-HotSpotResult detectHotSpot(const P2ProFrame &frame, bool previouslyFound) {
-    if (frame.thermal.empty()) return {};
-
+HotSpotResult detectHotSpot(const P2ProFrame &frame, const FrameStats &stats, const ThermalCalibration &calibration,
+                            bool previouslyFound) {
     int width = 256;
-    int height = 192;
     HotSpotResult res;
-    res.found = false;
-    uint16_t maxVal = 0;
-    double totalSum = 0;
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            uint16_t val = frame.thermal[y * width + x];
-            totalSum += val;
-            if (!res.found || val > maxVal) {
-                res.found = true;
-                res.x = x;
-                res.y = y;
-                maxVal = val;
-            }
-        }
-    }
-
+    res.found = !stats.empty();
     if (!res.found) return res;
 
-    double avgVal = totalSum / (width * height);
-    double threshold = previouslyFound ? 96.0 : 128.0; // Hysteresis: 1.5C vs 2.0C
+    uint16_t maxVal = stats.max;
+    res.x = stats.maxIndex % width;
+    res.y = stats.maxIndex / width;
+    res.fx = stats.peakX >= 0 ? stats.peakX : (float) res.x;
+    res.fy = stats.peakY >= 0 ? stats.peakY : (float) res.y;
+
+    double avgVal = stats.mean();
+    double threshold = previouslyFound ? 64.0 : 96.0; // Hysteresis on the filtered plane: 1.0C vs 1.5C
 
     if ((double) maxVal - avgVal > threshold) {
         res.val = maxVal;
-        res.tempC = (maxVal / 64.0) - 273.15;
+        res.peak = std::max(stats.peakValue, (float) maxVal);
+        res.temperature = calibration.toTemperatureInterpolated(res.peak);
 
         // Extract color from RGB frame
         if (frame.rgb.size() >= (size_t) (res.y * width + res.x) * 3 + 3) {
@@ -128,45 +150,231 @@ HotSpotResult detectHotSpot(const P2ProFrame &frame, bool previouslyFound) {
     return res;
 }
 
-void annotateFrame(P2ProFrame &frame, const HotSpotResult &res) {
+// Applies the camera's emissivity and environment settings to the host side temperature readout
+void loadCalibration(P2Pro &camera, ThermalCalibration &calibration) {
+    auto params = ThermalCalibration::Params::fromTpd(
+            camera.get_prop_tpd_params(PropTpdParams::TPD_PROP_EMS),
+            camera.get_prop_tpd_params(PropTpdParams::TPD_PROP_TU),
+            camera.get_prop_tpd_params(PropTpdParams::TPD_PROP_TA),
+            camera.get_prop_tpd_params(PropTpdParams::TPD_PROP_TAU));
+    calibration.setParams(params);
+    dprintf("Calibration: emissivity %.2f, reflected %.1f K, atmosphere %.1f K, transmittance %.2f\n",
+            params.emissivity, params.reflectedK, params.atmosphericK, params.transmittance);
+}
+
+// Loads the camera's stored bad pixel map. Without one nothing is corrected: the scan compares
+// each pixel with its neighbours, so it has to be started by the user with the camera on a
+// uniform scene or it would map small hot objects as dead pixels.
+void loadBadPixelMap(const std::string &serial, BadPixelCorrector &corrector) {
+    if (corrector.load(DeviceStorage::path(serial, "badpixels.bin"))) {
+        dprintf("Loaded bad pixel map for %s: %d pixels\n", serial.c_str(), corrector.badCount());
+    } else {
+        corrector.clear();
+        dprintf("No bad pixel map for %s, aim at a uniform scene and press 'p' (or send 'badpixels') to scan\n",
+                serial.c_str());
+    }
+}
+
+// Loads the camera's stored flat-field map; without one only the column noise tracking runs, if
+// enabled
+void loadFlatField(const std::string &serial, FlatFieldCorrector &corrector) {
+    if (corrector.load(DeviceStorage::path(serial, "flatfield.bin"))) {
+        dprintf("Loaded flat-field map for %s\n", serial.c_str());
+    } else {
+        corrector.reset();
+    }
+}
+
+// Used when there is no alarms.conf: any 2x2 cell warming faster than 2 K/s over 2 s
+std::vector<AlarmEngine::Rule> defaultAlarmRules() {
+    AlarmEngine::Rule rise;
+    rise.name = "rapid-rise";
+    rise.source = AlarmEngine::Source::Pixels;
+    rise.condition = AlarmEngine::Condition::Rise;
+    rise.threshold = 2.0;
+    rise.window = 2.0;
+    return {rise};
+}
+
+// Reports new alarm events and appends them to the recording's alarm log when one is open
+void drainAlarmEvents(const AlarmEventLog &log, uint64_t &cursor, FILE *csv) {
+    AlarmEvent events[16];
+    int count;
+    do {
+        cursor = log.read(cursor, events, 16, count);
+        for (int i = 0; i < count; ++i) {
+            const AlarmEvent &e = events[i];
+            dprintf("Alarm %s %s (%.2f)\n", e.name, e.raised ? "raised" : "cleared", e.value);
+            if (csv) {
+                fprintf(csv, "%lld,%s,%s,%.3f\n", (long long) e.timeMs, e.name, e.raised ? "raised" : "cleared", e.value);
+            }
+        }
+    } while (count == 16);
+}
+
+// Draws the hot spot crosshair and blob outlines straight into the recorder's YUV 4:2:0 planes
+void annotateFrame(const ColorConversion::PlanarYUV420 &planes, const HotSpotResult &res, const std::vector<Blob> &blobs) {
+    int width = planes.width;
+    int height = planes.height;
+    uint8_t y, u, v;
+
+    auto plot = [&](int px, int py) {
+        planes.y[py * planes.strideY + px] = y;
+        planes.u[(py / 2) * planes.strideU + px / 2] = u;
+        planes.v[(py / 2) * planes.strideV + px / 2] = v;
+    };
+
+    for (const Blob &b: blobs) {
+        if (b.cold) ColorConversion::RGBtoYUV(64, 160, 255, y, u, v);
+        else ColorConversion::RGBtoYUV(255, 64, 64, y, u, v);
+
+        int x0 = std::max(b.minX, 0), x1 = std::min(b.maxX, width - 1);
+        int y0 = std::max(b.minY, 0), y1 = std::min(b.maxY, height - 1);
+        for (int px = x0; px <= x1; ++px) {
+            plot(px, y0);
+            plot(px, y1);
+        }
+        for (int py = y0; py <= y1; ++py) {
+            plot(x0, py);
+            plot(x1, py);
+        }
+    }
+
     if (!res.found) return;
 
-    int width = 256;
-    int height = 192;
-    uint8_t r = 255 - res.r;
-    uint8_t g = 255 - res.g;
-    uint8_t b = 255 - res.b;
+    ColorConversion::RGBtoYUV(255 - res.r, 255 - res.g, 255 - res.b, y, u, v);
 
     // Simple crosshair drawing
     int crossSize = 10;
     for (int i = -crossSize; i <= crossSize; ++i) {
         if (res.x + i >= 0 && res.x + i < width) {
-            int idx = (res.y * width + (res.x + i)) * 3;
-            frame.rgb[idx] = r;
-            frame.rgb[idx + 1] = g;
-            frame.rgb[idx + 2] = b;
+            plot(res.x + i, res.y);
         }
         if (res.y + i >= 0 && res.y + i < height) {
-            int idx = ((res.y + i) * width + res.x) * 3;
-            frame.rgb[idx] = r;
-            frame.rgb[idx + 1] = g;
-            frame.rgb[idx + 2] = b;
+            plot(res.x, res.y + i);
         }
     }
 }
 
+// What the capture thread hands to the display with each frame
+struct DisplayFrame {
+    FramePool::Handle frame; // empty once the camera disconnected
+    HotSpotResult hotSpot;
+    std::vector<Blob> blobs;
+};
+
+namespace {
+    enum class RecordRequest {
+        Start,
+        Stop,
+        Toggle
+    };
+
+    volatile sig_atomic_t quitSignal = 0;
+    volatile sig_atomic_t recordSignal = 0;
+
+    void onSignal(int sig) {
+        if (sig == SIGUSR1) recordSignal = 1;
+        else quitSignal = 1;
+    }
+
+    sigset_t controlSignals() {
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGINT);
+        sigaddset(&set, SIGTERM);
+        sigaddset(&set, SIGUSR1);
+        return set;
+    }
+
+    // Called before any other thread starts, which inherit the mask: a handler running on the
+    // capture thread would interrupt its blocking calls and look like a camera disconnect
+    void blockControlSignals() {
+        sigset_t set = controlSignals();
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    }
+
+    // Headless mode: SIGINT/SIGTERM quit, SIGUSR1 toggles recording. Only the calling thread
+    // unblocks them, so the handlers always run there. No SA_RESTART, so a signal also ends the
+    // control server's wait right away.
+    void installSignalHandlers() {
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = onSignal;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+        sigaction(SIGUSR1, &action, nullptr);
+        // A control client that disconnects mid-reply must not kill the process
+        signal(SIGPIPE, SIG_IGN);
+
+        sigset_t set = controlSignals();
+        pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+    }
+}
+
 int main(int argc, char *argv[]) {
     try {
         dprintf("Application Start\n");
-        CameraWindow window("P2Pro Viewer", 256, 192); // Display only the pseudo color part initially
-        dprintf("Initializing Window...\n");
-        if (!window.init()) {
-            dprintf("Failed to initialize window.\n");
-            return -1;
+        // --headless runs capture, analysis, alarms and recording without SDL, controlled through
+        // signals and a Unix socket (--control <path>, by default control.sock in the
+        // configuration directory). --burn-legend adds the temperature legend to recordings,
+        // --column-tracking enables the scene-based column noise correction
+        bool headless = false;
+        bool burnLegend = false;
+        bool columnTracking = false;
+        std::string controlPath;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--headless") == 0) {
+                headless = true;
+            } else if (std::strcmp(argv[i], "--burn-legend") == 0) {
+                burnLegend = true;
+            } else if (std::strcmp(argv[i], "--column-tracking") == 0) {
+                columnTracking = true;
+            } else if (std::strcmp(argv[i], "--control") == 0 && i + 1 < argc) {
+                controlPath = argv[++i];
+            } else {
+                dprintf("Unknown argument: %s\n", argv[i]);
+            }
+        }
+
+        // Frames in flight: one being processed, three in the display handoff, one shown by the
+        // window and a spare. Declared before the window so it outlives the window's reference
+        // to the last frame
+        FramePool framePool(6, 256, 192);
+        std::unique_ptr<CameraWindow> window;
+        if (!headless) {
+            window.reset(new CameraWindow("P2Pro Viewer", 256, 192)); // Display only the pseudo color part initially
+            dprintf("Initializing Window...\n");
+            if (!window->init()) {
+                dprintf("Failed to initialize window.\n");
+                return -1;
+            }
+        }
+
+        ThermalCalibration calibration;
+        RoiAnalyzer roiAnalyzer(256, 192);
+
+        BadPixelCorrector badPixels(256, 192);
+        BadPixelAnalyzer badPixelScan(256, 192);
+        FlatFieldCorrector flatField(256, 192);
+        FlatFieldCorrector::Params flatFieldParams;
+        flatFieldParams.columnTracking = columnTracking;
+        flatField.setParams(flatFieldParams);
+        PixelStatsAccumulator pixelStats(256, 192);
+        AlarmEngine alarms(256, 192);
+        if (!alarms.loadRules(DeviceStorage::directory() + "/alarms.conf")) {
+            alarms.setRules(defaultAlarmRules());
         }
+        uint64_t alarmCursor = 0;
+        FILE *alarmLog = nullptr;
+        std::string cameraSerial;
+
+        PipelineMetrics metrics;
 
         dprintf("Initializing P2Pro camera object...\n");
         P2Pro camera;
+        camera.set_metrics(&metrics);
         dprintf("Connecting to P2Pro camera (USB and Video)...\n");
 
         bool cameraConnected = camera.connect();
@@ -184,86 +392,373 @@ int main(int argc, char *argv[]) {
             dprintf("\n");
 
             camera.pseudo_color_set(0, PseudoColorTypes::PSEUDO_IRON_RED);
+            loadCalibration(camera, calibration);
+            cameraSerial = camera.get_serial_number();
+            loadBadPixelMap(cameraSerial, badPixels);
+            loadFlatField(cameraSerial, flatField);
+            pixelStats.openSnapshot(DeviceStorage::path(cameraSerial, "pixelstats.bin"));
+        }
+
+        // The capture thread owns the camera, the processing chain and the recorder; this thread
+        // owns SDL (which must stay on the main thread on macOS) and only shows the newest
+        // result. Analyzers both sides touch are guarded by analysisMutex, which the window holds
+        // only while handling input or building its overlay, never across a present.
+        std::mutex analysisMutex;
+        if (window) {
+            window->setCalibration(&calibration);
+            window->setRoiAnalyzer(&roiAnalyzer);
+            window->setPixelStats(&pixelStats);
+            window->setAlarmEngine(&alarms);
+            window->setPipelineMetrics(&metrics);
+            window->setAnalysisMutex(&analysisMutex);
         }
+        TripleBuffer<DisplayFrame> display;
+        std::atomic<bool> running{true};
+        // Recording requests in arrival order, resolved by the capture thread against the recorder's
+        // actual state so start and stop are idempotent and none is merged into another
+        std::mutex recordRequestMutex;
+        std::vector<RecordRequest> recordRequests;
+        auto requestRecording = [&](RecordRequest request) {
+            std::lock_guard<std::mutex> lock(recordRequestMutex);
+            recordRequests.push_back(request);
+        };
+        std::atomic<bool> badPixelScanRequest{false};
+        std::atomic<bool> flatFieldRequest{false};
+        std::atomic<bool> recording{false};
+        std::atomic<bool> connected{cameraConnected};
+        std::string recordingFile; // guarded by analysisMutex
+        auto wakeDisplay = [&] {
+            if (window) window->wake();
+        };
+
+        // Signals arriving until the handlers are installed stay pending for the main thread
+        if (headless) blockControlSignals();
 
         dprintf("Entering main loop...\n");
-        bool running = true;
-        VideoRecorder recorder;
-        HotSpotTracker tracker;
-        bool indicatorVisible = true;
-        auto lastBlinkTime = std::chrono::steady_clock::now();
-        auto lastConnectAttempt = std::chrono::steady_clock::now();
-        bool recordToggleRequested = false;
-        HotSpotResult hs;
-
-        while (running) {
-            window.pollEvents(running, recordToggleRequested);
-
-            if (!cameraConnected) {
-                auto now = std::chrono::steady_clock::now();
-                if (std::chrono::duration_cast<std::chrono::seconds>(now - lastConnectAttempt).count() >= 1) {
-                    lastConnectAttempt = now;
-                    if (camera.connect()) {
-                        dprintf("Reconnected to P2Pro camera!\n");
-                        cameraConnected = true;
-                        camera.pseudo_color_set(0, PseudoColorTypes::PSEUDO_IRON_RED);
+        std::thread captureThread([&] {
+            // An exception here would otherwise terminate the process without a word; the window
+            // stays up and shows the camera as disconnected
+            try {
+                VideoRecorder recorder;
+                ColorbarLegend recordLegend; // only rasterized again when its range labels change
+                HotSpotTracker tracker;
+                TemporalFilter temporalFilter(256, 192);
+                BlobDetector blobDetector(256, 192);
+                BlobTracker blobTracker;
+                auto lastConnectAttempt = std::chrono::steady_clock::now();
+                auto recordStart = std::chrono::steady_clock::now();
+                auto lastStatsSnapshot = std::chrono::steady_clock::now();
+                HotSpotResult hs;
+                std::vector<uint8_t> badPixelFlags;
+                std::vector<RecordRequest> pendingRecordRequests;
+
+                auto stopRecording = [&] {
+                    recorder.stop();
+                    recording = false;
+                    std::lock_guard<std::mutex> lock(analysisMutex);
+                    roiAnalyzer.closeLog();
+                    if (alarmLog) fclose(alarmLog);
+                    alarmLog = nullptr;
+                };
+
+                while (running) {
+                    if (!cameraConnected) {
+                        auto now = std::chrono::steady_clock::now();
+                        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastConnectAttempt).count() >= 1) {
+                            lastConnectAttempt = now;
+                            if (camera.connect()) {
+                                dprintf("Reconnected to P2Pro camera!\n");
+                                cameraConnected = true;
+                                camera.pseudo_color_set(0, PseudoColorTypes::PSEUDO_IRON_RED);
+                                cameraSerial = camera.get_serial_number();
+                                loadBadPixelMap(cameraSerial, badPixels);
+                                loadFlatField(cameraSerial, flatField);
+                                std::lock_guard<std::mutex> lock(analysisMutex);
+                                loadCalibration(camera, calibration);
+                                pixelStats.openSnapshot(DeviceStorage::path(cameraSerial, "pixelstats.bin"));
+                            }
+                        }
+                        if (!cameraConnected) {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                            continue;
+                        }
+                        connected = true;
+                        wakeDisplay();
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(recordRequestMutex);
+                        pendingRecordRequests.swap(recordRequests);
+                    }
+                    for (RecordRequest request: pendingRecordRequests) {
+                        bool wanted = request == RecordRequest::Start ? true
+                                    : request == RecordRequest::Stop ? false : !recorder.isRecording();
+                        if (wanted == recorder.isRecording()) continue;
+                        if (!wanted) {
+                            stopRecording();
+                        } else {
+                            // Start recording (256x192 at 25 fps); region measurements and alarm events go to
+                            // CSV files next to the video
+                            if (recorder.start(256, 192, 25.0)) {
+                                std::string logName = recorder.getFilename();
+                                logName = logName.substr(0, logName.find_last_of('.'));
+                                {
+                                    std::lock_guard<std::mutex> lock(analysisMutex);
+                                    roiAnalyzer.openLog(logName + ".csv");
+                                    recordingFile = recorder.getFilename();
+                                }
+                                alarmLog = fopen((logName + "-alarms.csv").c_str(), "w");
+                                if (alarmLog) fprintf(alarmLog, "time_ms,rule,state,value\n");
+                                recordStart = std::chrono::steady_clock::now();
+                                recording = true;
+                            }
+                        }
+                        wakeDisplay();
+                    }
+                    pendingRecordRequests.clear();
+
+                    if (badPixelScanRequest.exchange(false)) {
+                        dprintf("Scanning bad pixels, keep the camera on a uniform scene...\n");
+                        badPixelScan.start();
+                    }
+
+                    if (flatFieldRequest.exchange(false)) {
+                        dprintf("Capturing flat field, keep the camera on a uniform scene...\n");
+                        flatField.startCapture();
+                    }
+
+                    if (badPixelScan.takeResult(badPixelFlags)) {
+                        badPixels.setMap(badPixelFlags);
+                        badPixels.save(DeviceStorage::path(cameraSerial, "badpixels.bin"));
+                        dprintf("Bad pixel scan finished: %d pixels flagged\n", badPixels.badCount());
+                    }
+
+                    // Every pool frame is preallocated, so steady-state capture allocates nothing. A
+                    // frame is only missing if the display holds on to all of them; skip a beat then
+                    FramePool::Handle frame = framePool.acquire();
+                    if (!frame) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        continue;
+                    }
+
+                    if (camera.get_frame(*frame, recorder.isRecording())) {
+                        metrics.frameCaptured(frame->sequence);
+                        // The scan needs the uncorrected plane and the flat-field capture the plane
+                        // before its own correction; every stage below sees the corrected, denoised one
+                        badPixelScan.addFrame(frame->thermal.data());
+                        badPixels.apply(frame->thermal.data());
+                        if (flatField.isCapturing() && flatField.addCaptureFrame(frame->thermal.data())) {
+                            flatField.save(DeviceStorage::path(cameraSerial, "flatfield.bin"));
+                            temporalFilter.reset();
+                            dprintf("Flat-field capture finished\n");
+                        }
+                        flatField.apply(frame->thermal.data());
+                        // Long-term statistics see the calibrated but unfiltered plane, so their
+                        // variance is the real temporal variance
+                        auto wallClock = std::chrono::system_clock::now().time_since_epoch();
+                        int64_t frameTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(wallClock).count();
+                        {
+                            std::lock_guard<std::mutex> lock(analysisMutex);
+                            pixelStats.add(frame->thermal.data(), frameTimeMs);
+                        }
+                        temporalFilter.process(frame->thermal.data());
+
+                        // One pass over the Y16 plane shared by every consumer of frame statistics
+                        int64_t statsStart = PipelineMetrics::nowUs();
+                        FrameStats stats = FrameStats::compute(frame->thermal.data(), 256, 192);
+                        int64_t hotSpotTime = PipelineMetrics::nowUs() - statsStart;
+                        blobDetector.detect(frame->thermal.data(), stats);
+                        blobTracker.update(blobDetector.blobs());
+                        {
+                            std::lock_guard<std::mutex> lock(analysisMutex);
+                            int64_t detectStart = PipelineMetrics::nowUs();
+                            hs = detectHotSpot(*frame, stats, calibration, hs.found);
+                            hotSpotTime += PipelineMetrics::nowUs() - detectStart;
+                            metrics.record(PipelineMetrics::HotSpot, hotSpotTime);
+                            if (burnLegend && recorder.isRecording()) {
+                                // The camera's iron red AGC spans roughly the frame's range
+                                recordLegend.set(Palette::Type::IronRed, calibration.toTemperature(stats.min),
+                                                 calibration.toTemperature(stats.max), calibration.unitSuffix());
+                            }
+                            if (!roiAnalyzer.rois().empty()) {
+                                roiAnalyzer.update(frame->thermal.data(), &ThreadPool::shared());
+                                if (recorder.isRecording()) {
+                                    auto elapsed = std::chrono::steady_clock::now() - recordStart;
+                                    roiAnalyzer.logFrame(std::chrono::duration<double>(elapsed).count(), calibration);
+                                }
+                            }
+                            // Rates are timed on the steady clock, events stamped with the wall clock
+                            int64_t steadyUs = frame->captureTimeUs > 0 ? frame->captureTimeUs : PipelineMetrics::nowUs();
+                            alarms.evaluate(frame->thermal.data(), stats, &roiAnalyzer, calibration, steadyUs,
+                                            frameTimeMs);
+                        }
+                        drainAlarmEvents(alarms.events(), alarmCursor, alarmLog);
+                        tracker.update(hs, *frame);
+
+                        ColorConversion::PlanarYUV420 planes;
+                        if (recorder.isRecording() && !frame->yuy2.empty() && recorder.beginFrame(planes)) {
+                            PipelineMetrics::Timer timer(&metrics, PipelineMetrics::Encode);
+                            ColorConversion::YUY2toYUV420P(frame->yuy2.data(), planes);
+                            annotateFrame(planes, hs, blobTracker.tracked());
+                            if (burnLegend) recordLegend.burn(planes);
+                            recorder.submitFrame();
+                        }
+
+                        // Hand the clean frame (overlay rendered separately) to the display
+                        DisplayFrame &out = display.back();
+                        out.frame = std::move(frame);
+                        out.hotSpot = hs;
+                        out.blobs = blobTracker.tracked();
+                        display.publish();
+                        wakeDisplay();
+                    } else {
+                        dprintf("Camera disconnected!\n");
+                        cameraConnected = false;
+                        camera.disconnect();
+                        if (recorder.isRecording()) {
+                            dprintf("Stopping recording due to disconnection.\n");
+                            stopRecording();
+                        }
+                        hs.found = false;
+                        blobDetector.clear();
+                        blobTracker.clear();
+                        temporalFilter.reset();
+                        {
+                            std::lock_guard<std::mutex> lock(analysisMutex);
+                            pixelStats.closeSnapshot();
+                            alarms.resetHistory();
+                        }
+
+                        DisplayFrame &out = display.back();
+                        out.frame.reset();
+                        out.hotSpot = hs;
+                        out.blobs.clear();
+                        display.publish();
+                        connected = false;
+                        wakeDisplay();
+                    }
+
+                    // Mirror the long-term statistics to disk once a minute; the flush itself is asynchronous
+                    auto now = std::chrono::steady_clock::now();
+                    if (cameraConnected && now - lastStatsSnapshot > std::chrono::minutes(1)) {
+                        std::lock_guard<std::mutex> lock(analysisMutex);
+                        pixelStats.snapshot();
+                        lastStatsSnapshot = now;
                     }
                 }
-            }
 
-            if (recordToggleRequested && cameraConnected) {
                 if (recorder.isRecording()) {
-                    recorder.stop();
-                } else {
-                    // Start recording (256x192 at 25 fps)
-                    recorder.start(256, 192, 25.0);
+                    stopRecording();
                 }
+            } catch (const std::exception &e) {
+                dprintf("Capture error: %s\n", e.what());
+                connected = false;
+                wakeDisplay();
             }
+        });
+
+        if (window) {
+            bool indicatorVisible = true;
+            auto lastBlinkTime = std::chrono::steady_clock::now();
+            bool recordToggleRequested = false;
+            bool windowOpen = true;
+            DisplayFrame noFrame;
+            const DisplayFrame *shown = &noFrame;
+
+            while (windowOpen) {
+                window->pollEvents(windowOpen, recordToggleRequested);
+                if (recordToggleRequested && connected) requestRecording(RecordRequest::Toggle);
+                if (window->takeBadPixelScanRequest() && connected) badPixelScanRequest = true;
+                if (window->takeFlatFieldRequest() && connected) flatFieldRequest = true;
+
+                if (display.update()) {
+                    shown = &display.front();
+                    if (shown->frame) window->updateFrame(shown->frame);
+                }
 
-            P2ProFrame frame;
-            if (cameraConnected) {
-                if (camera.get_frame(frame)) {
-                    hs = detectHotSpot(frame, hs.found);
-                    tracker.update(hs, frame);
-
-                    // Update window with clean frame (overlay rendered separately)
-                    window.updateFrame(frame.rgb, frame.thermal, 256, 192);
-
-                    if (recorder.isRecording()) {
-                        P2ProFrame annotated = frame;
-                        annotateFrame(annotated, hs);
-                        recorder.writeFrame(annotated.rgb);
+                bool isRecording = recording;
+                if (isRecording) {
+                    auto now = std::chrono::steady_clock::now();
+                    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastBlinkTime).count() > 500) {
+                        indicatorVisible = !indicatorVisible;
+                        lastBlinkTime = now;
                     }
                 } else {
-                    dprintf("Camera disconnected!\n");
-                    cameraConnected = false;
-                    camera.disconnect();
-                    if (recorder.isRecording()) {
-                        dprintf("Stopping recording due to disconnection.\n");
-                        recorder.stop();
-                    }
-                    hs.found = false;
+                    indicatorVisible = false;
                 }
-            }
 
-            window.render(recorder.isRecording(), indicatorVisible, cameraConnected, hs);
+                window->render(isRecording, indicatorVisible, connected, shown->hotSpot, shown->blobs);
 
-            if (recorder.isRecording()) {
-                auto now = std::chrono::steady_clock::now();
-                if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastBlinkTime).count() > 500) {
-                    indicatorVisible = !indicatorVisible;
-                    lastBlinkTime = now;
-                }
+                // Woken early by new frames and input; the timeout keeps the recording indicator blinking
+                window->waitForEvents(50);
+            }
+        } else {
+            installSignalHandlers();
+            if (controlPath.empty()) controlPath = DeviceStorage::directory() + "/control.sock";
+            ControlServer control;
+            if (control.open(controlPath)) {
+                dprintf("Headless mode, control socket: %s\n", controlPath.c_str());
             } else {
-                indicatorVisible = false;
+                dprintf("Headless mode without control socket; SIGUSR1 toggles recording\n");
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            // Commands: status, record start|stop|toggle, badpixels, flatfield, quit
+            auto handleCommand = [&](const std::string &command) -> std::string {
+                if (command == "status") {
+                    PipelineMetrics::Summary m = metrics.summarize();
+                    char line[128];
+                    std::string reply;
+                    snprintf(line, sizeof(line), "connected %s\ncapture_fps %.1f\ndropped %llu\n",
+                             connected ? "yes" : "no", m.captureFps, (unsigned long long) m.dropped);
+                    reply += line;
+                    std::lock_guard<std::mutex> lock(analysisMutex);
+                    reply += recording ? "recording " + recordingFile + "\n" : "recording no\n";
+                    const std::vector<AlarmEngine::Rule> &rules = alarms.rules();
+                    const std::vector<AlarmEngine::RuleState> &states = alarms.states();
+                    for (size_t i = 0; i < states.size() && i < rules.size(); ++i) {
+                        if (!states[i].active) continue;
+                        snprintf(line, sizeof(line), "alarm %s %.2f\n", rules[i].name.c_str(), states[i].value);
+                        reply += line;
+                    }
+                    return reply;
+                }
+                if (command == "record start" || command == "record stop" || command == "record toggle") {
+                    if (!connected) return "error camera not connected";
+                    requestRecording(command == "record start" ? RecordRequest::Start
+                                   : command == "record stop" ? RecordRequest::Stop : RecordRequest::Toggle);
+                    return "ok";
+                }
+                if (command == "badpixels") {
+                    if (!connected) return "error camera not connected";
+                    badPixelScanRequest = true;
+                    return "ok";
+                }
+                if (command == "flatfield") {
+                    if (!connected) return "error camera not connected";
+                    flatFieldRequest = true;
+                    return "ok";
+                }
+                if (command == "quit") {
+                    quitSignal = 1;
+                    return "ok";
+                }
+                return "error unknown command";
+            };
+
+            // The first summary covers everything since startup; start the status window here
+            metrics.summarize();
+            while (!quitSignal) {
+                control.poll(200, handleCommand);
+                if (recordSignal) {
+                    recordSignal = 0;
+                    if (connected) requestRecording(RecordRequest::Toggle);
+                }
+            }
+            dprintf("Shutting down...\n");
         }
 
-        if (recorder.isRecording()) {
-            recorder.stop();
-        }
+        running = false;
+        captureThread.join();
     } catch (const std::exception &e) {
         dprintf("Error: %s\n", e.what());
         return -1;
@@ -0,0 +1,163 @@
+// Checks that the per-frame processing chain does not allocate once it has warmed up: runs the
+// capture loop's stages from a pool frame to the colorized and encoded outputs on synthetic
+// frames while a replaced global operator new counts every heap allocation on any thread.
+// Exits non-zero when the steady-state frames allocated anything.
+// Usage: allocation_check [frames]
+#include "../src/FramePool.hpp"
+#include "../src/BadPixelCorrector.hpp"
+#include "../src/FlatFieldCorrector.hpp"
+#include "../src/PixelStatsAccumulator.hpp"
+#include "../src/TemporalFilter.hpp"
+#include "../src/FrameStats.hpp"
+#include "../src/BlobDetector.hpp"
+#include "../src/BlobTracker.hpp"
+#include "../src/RoiAnalyzer.hpp"
+#include "../src/AlarmEngine.hpp"
+#include "../src/DetailEnhancer.hpp"
+#include "../src/ThermalUpscaler.hpp"
+#include "../src/ThermalCalibration.hpp"
+#include "../src/ColorbarLegend.hpp"
+#include "../src/ColorConversion.hpp"
+#include "../src/Palette.hpp"
+#include "../src/ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static std::atomic<long> allocations{0};
+
+void *operator new(size_t size) {
+    allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    std::free(p);
+}
+
+// The library logs through dprintf, which lives with the USB code in P2Pro.cpp
+void dprintf(const char *, ...) {
+}
+
+int main(int argc, char *argv[]) {
+    const int width = 256, height = 192;
+    const int warmup = 200;
+    int frames = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (frames < 1) frames = 1;
+
+    ThreadPool &pool = ThreadPool::shared();
+    FramePool framePool(6, width, height);
+    BadPixelCorrector badPixels(width, height);
+    FlatFieldCorrector flatField(width, height);
+    FlatFieldCorrector::Params flatFieldParams;
+    flatFieldParams.columnTracking = true;
+    flatField.setParams(flatFieldParams);
+    PixelStatsAccumulator pixelStats(width, height);
+    TemporalFilter temporalFilter(width, height);
+    BlobDetector blobDetector(width, height);
+    BlobTracker blobTracker;
+    RoiAnalyzer roiAnalyzer(width, height);
+    roiAnalyzer.addRectangle({10, 10}, {60, 50});
+    AlarmEngine alarms(width, height);
+    AlarmEngine::Rule rise;
+    rise.name = "rapid-rise";
+    rise.source = AlarmEngine::Source::Pixels;
+    rise.condition = AlarmEngine::Condition::Rise;
+    rise.threshold = 2.0;
+    alarms.setRules({rise});
+    DetailEnhancer enhancer(width, height);
+    ThermalUpscaler upscaler(width, height);
+    ThermalCalibration calibration;
+    ColorbarLegend legend;
+
+    // Camera transfer, display and recording buffers as the capture loop and window hold them
+    std::vector<uint8_t> yuy2((size_t) width * height * 2);
+    std::vector<uint16_t> raw((size_t) width * height);
+    std::vector<uint16_t> zoomed((size_t) width * 2 * height * 2);
+    std::vector<uint8_t> gray((size_t) width * height);
+    std::vector<uint8_t> colorized((size_t) width * height * 3);
+    std::vector<uint8_t> encoded((size_t) width * height * 3 / 2);
+    ColorConversion::PlanarYUV420 planes;
+    planes.y = encoded.data();
+    planes.u = planes.y + width * height;
+    planes.v = planes.u + width * height / 4;
+    planes.strideY = width;
+    planes.strideU = planes.strideV = width / 2;
+    planes.width = width;
+    planes.height = height;
+
+    FramePool::Handle shown;
+    long baseline = 0;
+    for (int f = 0; f < warmup + frames; ++f) {
+        if (f == warmup) baseline = allocations;
+
+        // A warm object drifting across a sloped background
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                int dx = x - (f % width), dy = y - height / 2;
+                raw[(size_t) y * width + x] = (uint16_t) (19000 + x * 4 + y * 2 + (dx * dx + dy * dy < 64 ? 2000 : 0));
+                yuy2[((size_t) y * width + x) * 2] = (uint8_t) (x + f);
+                yuy2[((size_t) y * width + x) * 2 + 1] = (uint8_t) (128 + y);
+            }
+        }
+
+        // P2Pro::get_frame fills the pool frame in place
+        FramePool::Handle frame = framePool.acquire();
+        if (!frame) {
+            std::fprintf(stderr, "Frame pool exhausted at frame %d\n", f);
+            return 1;
+        }
+        std::copy(raw.begin(), raw.end(), frame->thermal.begin());
+        frame->yuy2.assign(yuy2.begin(), yuy2.end());
+        ColorConversion::YUY2toRGB(yuy2.data(), frame->rgb.data(), width, height, &pool);
+
+        int64_t timeMs = 1000000 + (int64_t) f * 40;
+        uint16_t *y16 = frame->thermal.data();
+        badPixels.apply(y16);
+        flatField.apply(y16);
+        pixelStats.add(y16, timeMs);
+        temporalFilter.process(y16);
+        FrameStats stats = FrameStats::compute(y16, width, height);
+        blobDetector.detect(y16, stats);
+        blobTracker.update(blobDetector.blobs());
+        roiAnalyzer.update(y16, &pool);
+        alarms.evaluate(y16, stats, &roiAnalyzer, calibration, timeMs * 1000, timeMs);
+
+        legend.set(Palette::Type::IronRed, calibration.toTemperature(stats.min), calibration.toTemperature(stats.max),
+                   calibration.unitSuffix());
+        ColorConversion::YUY2toYUV420P(frame->yuy2.data(), planes, &pool);
+        legend.burn(planes);
+
+        // Window side: zoomed, enhanced and colorized view of the shown frame
+        shown = std::move(frame);
+        upscaler.process(shown->thermal.data(), 64, 48, 128, 96, zoomed.data(), width * 2, height * 2,
+                         ThermalUpscaler::Method::Lanczos, &pool);
+        enhancer.process(shown->thermal.data(), gray.data(), &pool);
+        Palette::colorize(gray.data(), colorized.data(), width * height, Palette::Type::Rainbow);
+    }
+
+    long counted = allocations - baseline;
+    std::printf("%ld allocations over %d steady-state frames\n", counted, frames);
+    return counted == 0 ? 0 : 1;
+}
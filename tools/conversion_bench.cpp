@@ -0,0 +1,63 @@
+// Benchmarks the band-parallel color conversions at the output scales offered by CameraWindow.
+// Usage: conversion_bench [iterations]
+#include "../src/ColorConversion.hpp"
+#include "../src/ThreadPool.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+static double timeMs(int iterations, const std::function<void()> &fn) {
+    fn(); // warm-up, faults in the destination pages
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    if (iterations < 1) iterations = 1;
+
+    const int scales[] = {1, 2, 4, 8, 16};
+    const int threadCounts[] = {1, 2, 4, 8};
+
+    std::printf("%-6s %-11s %-8s %12s %9s %12s %9s\n",
+                "scale", "size", "threads", "YUY2toRGB ms", "speedup", "RGBtoBGR ms", "speedup");
+
+    for (int scale: scales) {
+        int width = 256 * scale;
+        int height = 192 * scale;
+
+        std::vector<uint8_t> yuy2((size_t) width * height * 2);
+        std::vector<uint8_t> rgb((size_t) width * height * 3);
+        std::vector<uint8_t> bgr((size_t) width * height * 3);
+        for (size_t i = 0; i < yuy2.size(); ++i) yuy2[i] = (uint8_t) (i * 31 + (i >> 9));
+
+        double baseYuy2 = 0, baseBgr = 0;
+        for (int threads: threadCounts) {
+            // A pool of size 1 runs inline, which is exactly the single-threaded path
+            std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>(threads);
+
+            double yuy2Ms = timeMs(iterations, [&] {
+                ColorConversion::YUY2toRGB(yuy2.data(), rgb.data(), width, height, pool.get());
+            });
+            double bgrMs = timeMs(iterations, [&] {
+                ColorConversion::RGBtoBGR(rgb.data(), bgr.data(), width, height, pool.get());
+            });
+
+            if (threads == 1) {
+                baseYuy2 = yuy2Ms;
+                baseBgr = bgrMs;
+            }
+
+            char size[16];
+            std::snprintf(size, sizeof(size), "%dx%d", width, height);
+            std::printf("%-6d %-11s %-8d %12.3f %8.2fx %12.3f %8.2fx\n",
+                        scale, size, threads, yuy2Ms, baseYuy2 / yuy2Ms, bgrMs, baseBgr / bgrMs);
+        }
+    }
+    return 0;
+}
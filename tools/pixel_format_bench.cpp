@@ -0,0 +1,70 @@
+// Measures every PixelFormat conversion pair and prints the throughput matrix in Mpix/s.
+// Usage: pixel_format_bench [width height [threads]]
+#include "../src/PixelFormat.hpp"
+#include "../src/ThreadPool.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using PixelFormat::Format;
+
+static double measureMpix(const PixelFormat::Image &src, const PixelFormat::Image &dst, ThreadPool *pool) {
+    PixelFormat::convert(src, dst, pool); // warm-up
+
+    // Repeat until at least 100 ms have passed so small frames are measured reliably
+    int iterations = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        PixelFormat::convert(src, dst, pool);
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 0.1);
+
+    return (double) src.width * src.height * iterations / elapsed / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    int width = argc > 2 ? std::atoi(argv[1]) : 256;
+    int height = argc > 2 ? std::atoi(argv[2]) : 192;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 1;
+    if (width < 2 || height < 2) {
+        std::fprintf(stderr, "Invalid size %dx%d\n", width, height);
+        return 1;
+    }
+    width &= ~1;
+    height &= ~1;
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) pool = std::make_unique<ThreadPool>(threads);
+
+    PixelFormat::ImageBuffer buffers[PixelFormat::FormatCount];
+    for (int f = 0; f < PixelFormat::FormatCount; ++f) {
+        buffers[f].allocate((Format) f, width, height);
+        for (size_t i = 0; i < buffers[f].storage.size(); ++i) {
+            buffers[f].storage[i] = (uint8_t) (i * 131 + (i >> 7));
+        }
+    }
+
+    std::printf("Pixel format conversions, %dx%d, %d thread(s), Mpix/s\n", width, height, threads < 1 ? 1 : threads);
+    std::printf("(* = SIMD kernel, + = dedicated scalar kernel, otherwise generic RGB24 round trip)\n\n");
+
+    std::printf("%-8s", "src\\dst");
+    for (int d = 0; d < PixelFormat::FormatCount; ++d) {
+        std::printf("%10s", PixelFormat::name((Format) d));
+    }
+    std::printf("\n");
+
+    for (int s = 0; s < PixelFormat::FormatCount; ++s) {
+        std::printf("%-8s", PixelFormat::name((Format) s));
+        for (int d = 0; d < PixelFormat::FormatCount; ++d) {
+            double mpix = measureMpix(buffers[s].image, buffers[d].image, pool.get());
+            char marker = PixelFormat::hasSimdKernel((Format) s, (Format) d) ? '*'
+                        : PixelFormat::hasDirectKernel((Format) s, (Format) d) ? '+' : ' ';
+            std::printf("%9.0f%c", mpix, marker);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}